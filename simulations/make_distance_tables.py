@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+#
+# make_distance_tables.py
+#
+#  Created on: 17 Oct 2026
+#      Author: mondals
+#
+# Converts WAP distance tables (ap_*.csv, one distance in m per line) to the
+# binary format read by DistanceTables: "WAPD", the 64-bit FNV-1a hash of the
+# .csv, a uint32 count and count float64 values, little-endian, so the
+# distances are exactly those of the text file. A .bin next to a .csv is
+# preferred by the sources as long as the hash matches the current .csv; after
+# editing a table the .csv is used until this is run again.
+#
+#   python3 make_distance_tables.py ../src/ap_*.csv
+
+import os
+import struct
+import sys
+
+
+def fnv1a(data):
+    h = 14695981039346656037
+    for b in data:
+        h = ((h ^ b) * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+for csv_file in sys.argv[1:]:
+    with open(csv_file, "rb") as f:
+        data = f.read()
+    values = [float(v) for v in data.split()]
+    bin_file = os.path.splitext(csv_file)[0] + ".bin"
+    with open(bin_file, "wb") as f:
+        f.write(b"WAPD" + struct.pack("<QI", fnv1a(data), len(values)) + struct.pack("<%dd" % len(values), *values))
+    print("%s: %d distances" % (bin_file, len(values)))
@@ -0,0 +1,394 @@
+#!/usr/bin/env python3
+#
+# run_sweep.py
+#
+#  Created on: 17 Oct 2026
+#      Author: mondals
+#
+# Runs all runs of a configuration on the local cores and merges the results.
+#
+#   python3 run_sweep.py -c General -j 8
+#   python3 run_sweep.py -c General --summary-only
+#
+# The run matrix comes from the simulation itself (-q runs), so iteration
+# variables, repetitions and constraints in omnetpp.ini are expanded exactly as
+# OMNeT++ does. Runs are started longest first: the cost of a run is its wall
+# time from an earlier sweep if known, otherwise its offered load. Each worker
+# takes the next run from one shared queue as soon as it is free, so long runs
+# never wait behind short ones. A run writes <config>-<run>.sca.tmp and only
+# renames it to .sca when it exits cleanly; existing .sca files are skipped, so
+# an interrupted sweep resumes where it stopped. A file is only taken as done
+# if its itervar lines match the run: when the iteration matrix changes, run
+# numbers shift, and a stale file of another parameter point is simulated again.
+#
+# At the end all .sca files of the configuration are merged into
+# <config>-summary.csv: for every scalar and every parameter point (the
+# iteration variables without the repetition) the mean and the 95% confidence
+# half width over the repetitions. LogHistogram scalars (the ones with an "hdr"
+# attribute) are additionally merged bucket by bucket over the repetitions,
+# and the quantiles of the merged histogram are written as <name>:merged_p<q>.
+#
+# Results are also kept in a content-addressed cache (results/cache by
+# default). The key of a run is a SHA-256 over its effective configuration
+# (-q rundetails: every resolved ini entry, the iteration variables and the
+# seeds), the NED files, sim_params.cc/.h, the WAP distance CSV files and the
+# simulation binary or libraries. A run whose key is in the cache is not
+# simulated; its stored .sca (and .vec) are copied instead. Edits that change
+# none of these, such as a new configuration section for other runs, leave the
+# keys of existing points unchanged.
+#
+# Only the Python standard library is used; everything runs offline.
+
+import argparse
+import csv
+import glob
+import hashlib
+import json
+import math
+import os
+import re
+import shutil
+import shlex
+import subprocess
+import sys
+import threading
+import time
+from collections import defaultdict
+
+QUANTILES = [0.5, 0.99, 0.999, 0.9999]
+
+# two-sided 95% Student t quantiles by degrees of freedom, 1.96 beyond the table
+T95 = [0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+
+def t95(dof):
+    return T95[dof] if dof < len(T95) else 1.96
+
+
+class Run:
+    def __init__(self, number, itervars):
+        self.number = number
+        self.itervars = itervars            # {"load": "0.1", "repetition": "0"}
+        self.cost = 1.0
+        self.cache_key = None
+
+    def key(self):
+        return ", ".join("%s=%s" % kv for kv in sorted(self.itervars.items()))
+
+
+def sim_command(args):
+    cmd = shlex.split(args.exe) + ["-u", "Cmdenv", "-c", args.config, "-n", args.ned_path]
+    if args.repeat:
+        cmd.append("--repeat=%d" % args.repeat)
+    return cmd + args.extra + [args.ini]
+
+
+def query_runs(args):
+    out = subprocess.run(sim_command(args)[:-1] + ["-s", "-q", "runs", args.ini],
+                         capture_output=True, text=True, check=True).stdout
+    runs = []
+    for line in out.splitlines():
+        m = re.match(r"\s*Run (\d+):(.*)$", line)
+        if m is None:
+            continue
+        itervars = dict(re.findall(r"\$(\w+)=([^,]+)", m.group(2)))
+        runs.append(Run(int(m.group(1)), {k: v.strip() for k, v in itervars.items()}))
+    if not runs:
+        sys.exit("no runs found for configuration %s:\n%s" % (args.config, out))
+    return runs
+
+
+def query_run_details(args):
+    """Effective configuration of every run, as printed by -q rundetails."""
+    out = subprocess.run(sim_command(args)[:-1] + ["-s", "-q", "rundetails", args.ini],
+                         capture_output=True, text=True, check=True).stdout
+    details, number = {}, None
+    for line in out.splitlines():
+        m = re.match(r"\s*Run (\d+):", line)
+        if m is not None:
+            number = int(m.group(1))
+            details[number] = []
+        if number is not None:
+            details[number].append(line.strip())
+    return {n: "\n".join(lines) for n, lines in details.items()}
+
+
+def input_files(args):
+    """Files besides the ini that decide the results: NED, model constants, distance tables, binary."""
+    files = set()
+    for directory in args.ned_path.split(":"):
+        files.update(glob.glob(os.path.join(directory, "**", "*.ned"), recursive=True))
+    for name in ["sim_params.cc", "sim_params.h"]:
+        files.add(os.path.join(args.src_dir, name))
+    for directory in [".", args.src_dir]:
+        files.update(glob.glob(os.path.join(directory, "ap_*.csv")) + glob.glob(os.path.join(directory, "ap_*.bin")))
+    exe = shlex.split(args.exe)
+    for i, token in enumerate(exe):
+        if os.path.isfile(token):
+            files.add(token)
+        elif i > 0 and exe[i - 1] == "-l":
+            files.update(glob.glob(token + ".so") + glob.glob(os.path.join(os.path.dirname(token) or ".", "lib" + os.path.basename(token) + ".so")))
+    return sorted(os.path.normpath(f) for f in files if os.path.isfile(f))
+
+
+def compute_cache_keys(args, runs):
+    common = hashlib.sha256()
+    for path in input_files(args):
+        common.update(os.path.basename(path).encode())
+        with open(path, "rb") as f:
+            common.update(hashlib.sha256(f.read()).digest())
+    common.update(" ".join(args.extra).encode())
+    details = query_run_details(args)
+    for run in runs:
+        key = common.copy()
+        # the header line names the configuration; only the resolved entries below it matter
+        key.update(details.get(run.number, run.key()).split("\n", 1)[-1].encode())
+        key.update(run.key().encode())
+        run.cache_key = key.hexdigest()
+
+
+def cache_lookup(args, run):
+    if run.cache_key is None:
+        return False
+    entry = os.path.join(args.cache_dir, run.cache_key)
+    if not os.path.exists(os.path.join(entry, "run.sca")):
+        return False
+    base = result_base(args, run)
+    shutil.copyfile(os.path.join(entry, "run.sca"), base + ".sca")
+    if os.path.exists(os.path.join(entry, "run.vec")):
+        shutil.copyfile(os.path.join(entry, "run.vec"), base + ".vec")
+    return True
+
+
+def cache_store(args, run):
+    if run.cache_key is None:
+        return
+    entry = os.path.join(args.cache_dir, run.cache_key)
+    tmp = entry + ".tmp%d-%d" % (os.getpid(), threading.get_ident())
+    os.makedirs(tmp, exist_ok=True)
+    base = result_base(args, run)
+    shutil.copyfile(base + ".sca", os.path.join(tmp, "run.sca"))
+    if os.path.exists(base + ".vec"):
+        shutil.copyfile(base + ".vec", os.path.join(tmp, "run.vec"))
+    try:
+        os.rename(tmp, entry)                   # atomic, a concurrent store of the same key wins
+    except OSError:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+
+def result_base(args, run):
+    return os.path.join(args.result_dir, "%s-%d" % (args.config, run.number))
+
+
+def same_itervars(a, b):
+    unquote = lambda d: {k: v.strip('"') for k, v in d.items()}
+    return unquote(a) == unquote(b)
+
+
+def is_done(args, run):
+    """True if the .sca of the run exists and belongs to the same parameter point."""
+    path = result_base(args, run) + ".sca"
+    if not os.path.exists(path):
+        return False
+    if same_itervars(read_sca(path)[0], run.itervars):
+        return True
+    print("%s is from another parameter point, run %d (%s) is simulated again" % (path, run.number, run.key()))
+    os.remove(path)
+    return False
+
+
+def estimate_costs(args, runs):
+    history = load_history(args)
+    for run in runs:
+        if run.key() in history:
+            run.cost = history[run.key()]
+        else:
+            run.cost = float(run.itervars.get("load", 1.0))     # event rate grows with the offered load
+
+
+def history_file(args):
+    return os.path.join(args.result_dir, "%s-runtimes.json" % args.config)
+
+
+def load_history(args):
+    try:
+        with open(history_file(args)) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+def execute(args, run, log):
+    base = result_base(args, run)
+    if cache_lookup(args, run):
+        log("run %d (%s) taken from the cache" % (run.number, run.key()))
+        return True, 0.0
+    cmd = sim_command(args)[:-1] + [
+        "-r", str(run.number),
+        "--cmdenv-express-mode=true",
+        "--output-scalar-file=%s.sca.tmp" % base,
+        "--output-vector-file=%s.vec" % base,
+        args.ini]
+    start = time.time()
+    with open(base + ".log", "w") as out:
+        status = subprocess.run(cmd, stdout=out, stderr=subprocess.STDOUT).returncode
+    elapsed = time.time() - start
+    if status == 0 and os.path.exists(base + ".sca.tmp"):
+        os.replace(base + ".sca.tmp", base + ".sca")
+        cache_store(args, run)
+    log("run %d (%s) %s after %.1f s" % (run.number, run.key(), "done" if status == 0 else "FAILED, see %s.log" % base, elapsed))
+    return status == 0, elapsed
+
+
+def run_all(args, runs):
+    pending = [r for r in runs if not is_done(args, r)]
+    print("%d runs, %d already done" % (len(runs), len(runs) - len(pending)))
+    pending.sort(key=lambda r: r.cost, reverse=True)     # longest first
+
+    lock = threading.Lock()
+    history = load_history(args)
+    failed = []
+
+    def log(text):
+        with lock:
+            print(text, flush=True)
+
+    def worker():
+        while True:
+            with lock:
+                if not pending:
+                    return
+                run = pending.pop(0)
+            ok, elapsed = execute(args, run, log)
+            with lock:
+                if not ok:
+                    failed.append(run)
+                elif elapsed > 0:                   # cache hits say nothing about the run time
+                    history[run.key()] = elapsed
+
+    threads = [threading.Thread(target=worker) for _ in range(max(1, args.jobs))]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    with open(history_file(args), "w") as f:
+        json.dump(history, f, indent=1, sort_keys=True)
+    return failed
+
+
+def read_sca(path):
+    """Returns (itervars, [(module, name, value, attributes)]) of one .sca file."""
+    itervars, scalars = {}, []
+    with open(path) as f:
+        for line in f:
+            fields = shlex.split(line)
+            if not fields:
+                continue
+            if fields[0] == "itervar" and len(fields) >= 3:
+                itervars[fields[1]] = fields[2]
+            elif fields[0] == "scalar" and len(fields) >= 4:
+                scalars.append((fields[1], fields[2], float(fields[3]), {}))
+            elif fields[0] == "attr" and scalars and len(fields) >= 3:
+                scalars[-1][3][fields[1]] = fields[2]
+            elif fields[0] == "attr" and not scalars and len(fields) >= 3 and fields[1] == "repetition":
+                itervars.setdefault("repetition", fields[2])       # a run attribute, not always an itervar line
+    return itervars, scalars
+
+
+def bucket_value(index, unit, sub_bits):
+    """Middle of a LogHistogram bucket, as in LogHistogram::valueOf()."""
+    sub_count = 1 << sub_bits
+    half = sub_count // 2
+    if index < sub_count:
+        return index * unit
+    k = index - sub_count
+    shift = k // half + 1
+    sub = k % half + half
+    return ((sub << shift) + (1 << shift) / 2) * unit
+
+
+def histogram_quantiles(buckets, unit, sub_bits):
+    total = sum(buckets.values())
+    result = {}
+    for q in QUANTILES:
+        rank = max(1, math.ceil(q * total))
+        seen = 0
+        for index in sorted(buckets):
+            seen += buckets[index]
+            if seen >= rank:
+                result[q] = bucket_value(index, unit, sub_bits)
+                break
+    return result
+
+
+def summarize(args):
+    values = defaultdict(list)                  # (point, module, name) -> values over the repetitions
+    histograms = {}                             # (point, module, name) -> [buckets, unit, sub_bits]
+    files = sorted(f for f in os.listdir(args.result_dir) if f.startswith(args.config + "-") and f.endswith(".sca"))
+    for file in files:
+        itervars, scalars = read_sca(os.path.join(args.result_dir, file))
+        point = ", ".join("%s=%s" % kv for kv in sorted(itervars.items()) if kv[0] != "repetition")
+        for module, name, value, attributes in scalars:
+            values[(point, module, name)].append(value)
+            if "hdr" in attributes:
+                unit, sub_bits = attributes.get("hdr_layout", "1e-09 10").split()
+                entry = histograms.setdefault((point, module, name), [defaultdict(int), float(unit), int(sub_bits)])
+                for pair in attributes["hdr"].split():
+                    index, count = pair.split(":")
+                    entry[0][int(index)] += int(count)
+
+    path = os.path.join(args.result_dir, "%s-summary.csv" % args.config)
+    with open(path, "w", newline="") as f:
+        out = csv.writer(f)
+        out.writerow(["point", "module", "name", "n", "mean", "ci95"])
+        for (point, module, name), v in sorted(values.items()):
+            n = len(v)
+            mean = sum(v) / n
+            ci = t95(n - 1) * math.sqrt(sum((x - mean) ** 2 for x in v) / (n - 1) / n) if n > 1 else float("nan")
+            out.writerow([point, module, name, n, "%.9g" % mean, "%.9g" % ci])
+        for (point, module, name), (buckets, unit, sub_bits) in sorted(histograms.items()):
+            if not buckets:
+                continue
+            base = name[:-len(":count")] if name.endswith(":count") else name
+            for q, value in histogram_quantiles(buckets, unit, sub_bits).items():
+                out.writerow([point, module, "%s:merged_p%g" % (base, q * 100), sum(buckets.values()), "%.9g" % value, ""])
+    print("%d result files merged into %s" % (len(files), path))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run a configuration on all local cores and merge the results.")
+    parser.add_argument("-c", "--config", default="General")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count())
+    parser.add_argument("-x", "--exe", default="../src/FTTR_50G_10G-PON_v3", help="simulation executable, or e.g. \"opp_run -l ../src/...\"")
+    parser.add_argument("-n", "--ned-path", default=".:../src")
+    parser.add_argument("-f", "--ini", default="omnetpp.ini")
+    parser.add_argument("-d", "--result-dir", default="results")
+    parser.add_argument("-s", "--src-dir", default="../src", help="model sources, for sim_params.cc and the distance files")
+    parser.add_argument("--cache-dir", default=None, help="result cache, default <result-dir>/cache")
+    parser.add_argument("--no-cache", action="store_true", help="simulate every run even if its results are cached")
+    parser.add_argument("--repeat", type=int, default=0, help="override the number of repetitions")
+    parser.add_argument("--summary-only", action="store_true", help="only merge the existing result files")
+    parser.add_argument("extra", nargs="*", help="further options for the simulation, after --")
+    args = parser.parse_args()
+
+    os.makedirs(args.result_dir, exist_ok=True)
+    if args.cache_dir is None:
+        args.cache_dir = os.path.join(args.result_dir, "cache")
+    os.makedirs(args.cache_dir, exist_ok=True)
+    failed = []
+    if not args.summary_only:
+        runs = query_runs(args)
+        estimate_costs(args, runs)
+        if not args.no_cache:
+            compute_cache_keys(args, runs)
+        failed = run_all(args, runs)
+    summarize(args)
+    if failed:
+        sys.exit("%d runs failed: %s" % (len(failed), " ".join(str(r.number) for r in failed)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+#
+# test_run_sweep.py
+#
+#  Created on: 17 Oct 2026
+#      Author: mondals
+#
+# Tests of run_sweep.py that need no simulation binary:
+#
+#   python3 -m unittest test_run_sweep
+
+import os
+import shutil
+import tempfile
+import unittest
+from types import SimpleNamespace
+
+import run_sweep
+
+SCA = """version 3
+run General-%d-20261017
+attr configname General
+attr repetition 0
+itervar load %s
+scalar net.olt "packet pool hit rate" 0.5
+"""
+
+
+class CachedRerunTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.args = SimpleNamespace(config="General", result_dir=self.dir, jobs=2,
+                                    cache_dir=os.path.join(self.dir, "cache"))
+        self.runs = [run_sweep.Run(n, {"load": load, "repetition": "0"}) for n, load in enumerate(["0.1", "0.2"])]
+        for run in self.runs:                   # as left behind by an earlier sweep
+            run.cache_key = "key%d" % run.number
+            entry = os.path.join(self.args.cache_dir, run.cache_key)
+            os.makedirs(entry)
+            with open(os.path.join(entry, "run.sca"), "w") as f:
+                f.write(SCA % (run.number, run.itervars["load"]))
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def test_cache_hits_are_not_failures(self):
+        failed = run_sweep.run_all(self.args, self.runs)
+        self.assertEqual(failed, [])
+        for run in self.runs:
+            self.assertTrue(run_sweep.is_done(self.args, run))
+        self.assertEqual(run_sweep.load_history(self.args), {})     # no run time from a cache hit
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,87 @@
+/*
+ * bw_map.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef BW_MAP_H_
+#define BW_MAP_H_
+
+#include <memory>
+#include <vector>
+#include <omnetpp.h>
+
+#include "gtc_header_m.h"
+
+using namespace omnetpp;
+
+/*
+ * Upstream bandwidth map of one polling cycle, indexed by ONU (at the OLT) or
+ * by SFU (at an MFU). It is built once per cycle and never modified afterwards,
+ * so every copy of the downlink header shares the same instance.
+ */
+struct BandwidthMap
+{
+    std::vector<double> rtt;                    // OLT-ONU or MFU-SFU round trip time
+    std::vector<double> start_time_TC2;
+    std::vector<double> grant_TC2;
+    std::vector<double> start_time_TC3;
+    std::vector<double> grant_TC3;
+    double tx_offset = 0;                       // header-to-transmission offset, see DBA::schedule()
+    bool standing = false;                      // idle map, repeats every cycle until the next header arrives
+};
+
+/*
+ * Downlink GTC header carrying a reference-counted bandwidth map. dup() only
+ * copies the reference, so broadcasting the header through a splitter costs
+ * O(1) per output gate instead of a copy of the full map. Only when the header
+ * crosses a parsim partition boundary is the map packed by value.
+ */
+class gtc_dl_header : public gtc_header
+{
+    private:
+        std::shared_ptr<const BandwidthMap> bw_map;
+
+    public:
+        gtc_dl_header(const char *name=nullptr, short kind=0) : gtc_header(name, kind) {}
+        gtc_dl_header(const gtc_dl_header& other) : gtc_header(other), bw_map(other.bw_map) {}
+        virtual gtc_dl_header *dup() const override { return new gtc_dl_header(*this); }
+
+        void setBwMap(std::shared_ptr<const BandwidthMap> map) { bw_map = map; }
+        const BandwidthMap& getBwMap() const { return *bw_map; }
+
+        virtual void parsimPack(cCommBuffer *buffer) const override {
+            gtc_header::parsimPack(buffer);
+            buffer->pack(bw_map != nullptr);
+            if(bw_map == nullptr)
+                return;
+            for(const std::vector<double> *v : {&bw_map->rtt, &bw_map->start_time_TC2, &bw_map->grant_TC2, &bw_map->start_time_TC3, &bw_map->grant_TC3}) {
+                buffer->pack((int)v->size());
+                buffer->pack(v->data(), v->size());
+            }
+            buffer->pack(bw_map->tx_offset);
+            buffer->pack(bw_map->standing);
+        }
+        virtual void parsimUnpack(cCommBuffer *buffer) override {
+            gtc_header::parsimUnpack(buffer);
+            bool has_map;
+            buffer->unpack(has_map);
+            if(!has_map) {
+                bw_map.reset();
+                return;
+            }
+            BandwidthMap *map = new BandwidthMap;
+            for(std::vector<double> *v : {&map->rtt, &map->start_time_TC2, &map->grant_TC2, &map->start_time_TC3, &map->grant_TC3}) {
+                int size;
+                buffer->unpack(size);
+                v->resize(size);
+                buffer->unpack(v->data(), size);
+            }
+            buffer->unpack(map->tx_offset);
+            buffer->unpack(map->standing);
+            bw_map.reset(map);
+        }
+};
+
+#endif /* BW_MAP_H_ */
@@ -0,0 +1,134 @@
+/*
+ * dba.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "sim_params.h"
+#include "dba.h"
+
+using namespace std;
+
+DBA *DBA::create(const char *policy, int units, double max_grant, double datarate)
+{
+    if(strcmp(policy, "limited") == 0)
+        return new LimitedDBA(units, max_grant, datarate);
+    if(strcmp(policy, "gated") == 0)
+        return new GatedDBA(units, max_grant, datarate);
+    if(strcmp(policy, "fixed") == 0)
+        return new FixedDBA(units, max_grant, datarate);
+    if(strcmp(policy, "limited_excess") == 0)
+        return new LimitedExcessDBA(units, max_grant, datarate);
+    throw cRuntimeError("Unknown DBA policy '%s' (expected limited, gated, fixed or limited_excess)", policy);
+}
+
+BandwidthMap *DBA::schedule(const vector<double>& rtt, const vector<double>& buffer_TC2, const vector<double>& buffer_TC3)
+{
+    BandwidthMap *bw_map = new BandwidthMap();
+    bw_map->rtt = rtt;
+    bw_map->grant_TC2.resize(units, 0);
+    bw_map->grant_TC3.resize(units, 0);
+    bw_map->start_time_TC2.resize(units, 0);
+    bw_map->start_time_TC3.resize(units, 0);
+
+    computeGrants(buffer_TC2, buffer_TC3, bw_map->grant_TC2, bw_map->grant_TC3);
+
+    // A unit transmits at header arrival + tx_offset + start time - its RTT, so that all bursts reach the
+    // receiver tx_offset + start time after this cycle. The worst RTT is the smallest offset for which no unit
+    // has to transmit before its header arrives, and it has to be common to all units to keep the frame aligned.
+    bw_map->tx_offset = *std::max_element(rtt.begin(), rtt.end());
+
+    double tx_start = 0;
+    for(int i = 0;i<units;i++) {
+        // start time for T-CONT 2
+        bw_map->start_time_TC2[i] = tx_start + T_guard;
+        // start time for T-CONT 3
+        bw_map->start_time_TC3[i] = tx_start + T_guard + (bw_map->grant_TC2[i]*8/datarate);
+        // shifting the tx_start cursor
+        tx_start += T_guard + (bw_map->grant_TC2[i]*8/datarate) + (bw_map->grant_TC3[i]*8/datarate);
+
+        granted_bytes += bw_map->grant_TC2[i] + bw_map->grant_TC3[i];
+    }
+    cycles++;
+    return bw_map;
+}
+
+/*
+ * True if nothing is reported and nothing is granted. As long as the reports
+ * stay empty every following cycle produces the same map, so the scheduler may
+ * send it once as a standing map and stop its cycle timer.
+ */
+bool DBA::isIdle(const vector<double>& buffer_TC2, const vector<double>& buffer_TC3, const BandwidthMap *bw_map) const
+{
+    for(int i = 0;i<units;i++) {
+        if((buffer_TC2[i] > 0) || (buffer_TC3[i] > 0) || (bw_map->grant_TC2[i] > 0) || (bw_map->grant_TC3[i] > 0))
+            return false;
+    }
+    return true;
+}
+
+double DBA::getUtilization() const
+{
+    if(cycles == 0)
+        return 0;
+    return granted_bytes*8/(cycles*max_polling_cycle*datarate);
+}
+
+void LimitedDBA::computeGrants(const vector<double>& buffer_TC2, const vector<double>& buffer_TC3, vector<double>& grant_TC2, vector<double>& grant_TC3)
+{
+    for(int i = 0;i<units;i++) {
+        double max_grant_TC2 = (buffer_TC2[i]/(buffer_TC2[i]+buffer_TC3[i]))*max_grant;
+        double max_grant_TC3 = (1-(buffer_TC2[i]/(buffer_TC2[i]+buffer_TC3[i])))*max_grant;
+
+        grant_TC2[i] = std::min(buffer_TC2[i], max_grant_TC2);      // granting BW using limited service policy
+        grant_TC3[i] = std::min(buffer_TC3[i], max_grant_TC3);
+    }
+}
+
+void GatedDBA::computeGrants(const vector<double>& buffer_TC2, const vector<double>& buffer_TC3, vector<double>& grant_TC2, vector<double>& grant_TC3)
+{
+    double capacity = units*max_grant;          // whole upstream frame of the cycle
+    for(int i = 0;i<units;i++) {
+        grant_TC2[i] = std::min(buffer_TC2[i], capacity);
+        capacity -= grant_TC2[i];
+        grant_TC3[i] = std::min(buffer_TC3[i], capacity);
+        capacity -= grant_TC3[i];
+    }
+}
+
+void FixedDBA::computeGrants(const vector<double>& buffer_TC2, const vector<double>& buffer_TC3, vector<double>& grant_TC2, vector<double>& grant_TC3)
+{
+    for(int i = 0;i<units;i++) {
+        grant_TC2[i] = max_grant/2;             // granting BW using fixed service policy
+        grant_TC3[i] = max_grant/2;
+    }
+}
+
+void LimitedExcessDBA::computeGrants(const vector<double>& buffer_TC2, const vector<double>& buffer_TC3, vector<double>& grant_TC2, vector<double>& grant_TC3)
+{
+    LimitedDBA::computeGrants(buffer_TC2, buffer_TC3, grant_TC2, grant_TC3);
+
+    double excess = 0;          // capacity not used by lightly loaded units
+    double total_unmet = 0;     // backlog left after the limited grants
+    for(int i = 0;i<units;i++) {
+        excess += std::max(0.0, max_grant - grant_TC2[i] - grant_TC3[i]);
+        total_unmet += std::max(0.0, buffer_TC2[i] - grant_TC2[i]) + std::max(0.0, buffer_TC3[i] - grant_TC3[i]);
+    }
+    if((total_unmet <= 0) || (excess <= 0))
+        return;
+
+    // every backlogged unit gets the same fraction of its unmet report, so nobody is granted more than it asked for
+    double fraction = std::min(1.0, excess/total_unmet);
+    for(int i = 0;i<units;i++) {
+        double unmet_TC2 = std::max(0.0, buffer_TC2[i] - grant_TC2[i]);
+        double unmet_TC3 = std::max(0.0, buffer_TC3[i] - grant_TC3[i]);
+        grant_TC2[i] += fraction*unmet_TC2;
+        grant_TC3[i] += fraction*unmet_TC3;
+    }
+    redistributed_bytes += fraction*total_unmet;
+}
@@ -0,0 +1,119 @@
+/*
+ * dba.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef DBA_H_
+#define DBA_H_
+
+#include <vector>
+#include <omnetpp.h>
+
+#include "bw_map.h"
+
+using namespace omnetpp;
+
+/*
+ * Dynamic bandwidth allocation engine, used by the OLT for its ONUs and by
+ * every MFU for its SFUs. A policy only decides the T-CONT 2/3 grant sizes from
+ * the latest buffer reports. The base class places the grants back-to-back in
+ * the upstream frame and returns the bandwidth map of the cycle.
+ */
+class DBA
+{
+    protected:
+        int units;                      // number of ONUs or SFUs served
+        double max_grant;               // per-unit grant limit in one cycle (bytes)
+        double datarate;                // upstream datarate (bps)
+
+        double granted_bytes = 0;       // sum of all grants handed out
+        double redistributed_bytes = 0; // part of it handed out as excess of other units
+        long cycles = 0;
+
+        virtual void computeGrants(const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3,
+                                   std::vector<double>& grant_TC2, std::vector<double>& grant_TC3) = 0;
+
+    public:
+        DBA(int units, double max_grant, double datarate) : units(units), max_grant(max_grant), datarate(datarate) {}
+        virtual ~DBA() {}
+
+        virtual const char *getPolicyName() const = 0;
+
+        // grants, start times and tx offset of one polling cycle, the caller takes ownership of the map
+        BandwidthMap *schedule(const std::vector<double>& rtt, const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3);
+
+        bool isIdle(const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3, const BandwidthMap *bw_map) const;
+        void skipCycles(long n) { cycles += n; }    // cycles left out by an idle scheduler, all without grants
+        void resetCounters() { granted_bytes = 0; redistributed_bytes = 0; cycles = 0; }
+
+        double getUtilization() const;  // granted share of the upstream capacity so far
+        double getRedistributedShare() const { return (granted_bytes > 0) ? redistributed_bytes/granted_bytes : 0; }
+
+        // policy selected by name: "limited", "gated", "fixed" or "limited_excess"
+        static DBA *create(const char *policy, int units, double max_grant, double datarate);
+};
+
+/*
+ * Limited service: each unit gets at most max_grant, split between T-CONT 2
+ * and T-CONT 3 in proportion to their reports.
+ */
+class LimitedDBA : public DBA
+{
+    protected:
+        virtual void computeGrants(const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3,
+                                   std::vector<double>& grant_TC2, std::vector<double>& grant_TC3) override;
+
+    public:
+        LimitedDBA(int units, double max_grant, double datarate) : DBA(units, max_grant, datarate) {}
+        virtual const char *getPolicyName() const override { return "limited"; }
+};
+
+/*
+ * Gated service: every report is granted in full, in polling order, until the
+ * capacity of the whole cycle (units x max_grant) is used up.
+ */
+class GatedDBA : public DBA
+{
+    protected:
+        virtual void computeGrants(const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3,
+                                   std::vector<double>& grant_TC2, std::vector<double>& grant_TC3) override;
+
+    public:
+        GatedDBA(int units, double max_grant, double datarate) : DBA(units, max_grant, datarate) {}
+        virtual const char *getPolicyName() const override { return "gated"; }
+};
+
+/*
+ * Fixed service: every unit gets max_grant/2 for each T-CONT, whatever it reports.
+ */
+class FixedDBA : public DBA
+{
+    protected:
+        virtual void computeGrants(const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3,
+                                   std::vector<double>& grant_TC2, std::vector<double>& grant_TC3) override;
+
+    public:
+        FixedDBA(int units, double max_grant, double datarate) : DBA(units, max_grant, datarate) {}
+        virtual const char *getPolicyName() const override { return "fixed"; }
+};
+
+/*
+ * Limited service with excess redistribution: the share left unused by lightly
+ * loaded units goes to the backlogged ones in proportion to their unserved
+ * TC2 + TC3 reports, and within a unit in proportion to its TC2 and TC3
+ * backlog. No unit gets more than it reported.
+ */
+class LimitedExcessDBA : public LimitedDBA
+{
+    protected:
+        virtual void computeGrants(const std::vector<double>& buffer_TC2, const std::vector<double>& buffer_TC3,
+                                   std::vector<double>& grant_TC2, std::vector<double>& grant_TC3) override;
+
+    public:
+        LimitedExcessDBA(int units, double max_grant, double datarate) : LimitedDBA(units, max_grant, datarate) {}
+        virtual const char *getPolicyName() const override { return "limited_excess"; }
+};
+
+#endif /* DBA_H_ */
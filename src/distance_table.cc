@@ -0,0 +1,78 @@
+/*
+ * distance_table.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+
+#include "distance_table.h"
+
+using namespace std;
+
+DistanceTables wap_distance_tables;
+
+const vector<double>& DistanceTables::get(const string& csv_file)
+{
+    auto it = tables.find(csv_file);
+    if(it != tables.end())
+        return it->second;
+
+    vector<double>& values = tables[csv_file];
+    size_t dot = csv_file.rfind('.');
+    if(!readBinary(csv_file.substr(0, dot) + ".bin", csv_file, values))
+        readText(csv_file, values);     // no binary table, or the text file was edited after the conversion
+    return values;
+}
+
+/*
+ * 64-bit FNV-1a of the raw bytes of a file, 0 if it cannot be read. Unlike a
+ * modification time it does not depend on the timestamp resolution.
+ */
+uint64_t DistanceTables::hashFile(const string& file)
+{
+    ifstream in(file, ios::binary);
+    if(!in)
+        return 0;
+    uint64_t hash = 14695981039346656037ULL;
+    for(istreambuf_iterator<char> it(in), end; it != end; ++it) {
+        hash ^= (unsigned char)*it;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool DistanceTables::readBinary(const string& file, const string& csv_file, vector<double>& values)
+{
+    ifstream in(file, ios::binary);
+    if(!in)
+        return false;
+
+    char magic[4];
+    uint64_t csv_hash;
+    uint32_t count;
+    if(!in.read(magic, 4) || (memcmp(magic, "WAPD", 4) != 0) || !in.read((char *)&csv_hash, sizeof(csv_hash)) || !in.read((char *)&count, sizeof(count)))
+        return false;
+    uint64_t current = hashFile(csv_file);
+    if((current != 0) && (current != csv_hash))
+        return false;                   // stale, converted from another version of the text file
+    values.resize(count);
+    if(!in.read((char *)values.data(), count*sizeof(double))) {
+        values.clear();
+        return false;
+    }
+    return true;
+}
+
+void DistanceTables::readText(const string& file, vector<double>& values)
+{
+    ifstream in(file);
+    double value;
+    while(in >> value) {
+        values.push_back(value);
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * distance_table.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef DISTANCE_TABLE_H_
+#define DISTANCE_TABLE_H_
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Device-to-WAP distances shared by all sources of the process. Each table is
+ * read once, on the first get() of its file name, and kept for the lifetime of
+ * the process, so a device only keeps the one distance it uses. When a binary
+ * table with the same stem exists (ap_xr.bin next to ap_xr.csv), it is read
+ * instead of the text file: the 4 bytes "WAPD", the 64-bit FNV-1a hash of the
+ * text file it was converted from, a uint32 count and count float64 values,
+ * all little-endian, so it gives exactly the distances of the text file. A
+ * binary table whose hash does not match the current text file is stale and
+ * ignored. A missing file gives an empty table.
+ */
+class DistanceTables
+{
+    private:
+        std::unordered_map<std::string, std::vector<double>> tables;
+
+        static uint64_t hashFile(const std::string& file);
+        static bool readBinary(const std::string& file, const std::string& csv_file, std::vector<double>& values);
+        static void readText(const std::string& file, std::vector<double>& values);
+
+    public:
+        const std::vector<double>& get(const std::string& csv_file);
+};
+
+extern DistanceTables wap_distance_tables;    // shared by all sources of the running process
+
+#endif /* DISTANCE_TABLE_H_ */
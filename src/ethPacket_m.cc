@@ -187,6 +187,7 @@ void ethPacket::copy(const ethPacket& other)
     this->MfuId = other.MfuId;
     this->TContId = other.TContId;
     this->FragmentCount = other.FragmentCount;
+    this->SequenceNumber = other.SequenceNumber;
 }
 
 void ethPacket::parsimPack(omnetpp::cCommBuffer *b) const
@@ -204,6 +205,7 @@ void ethPacket::parsimPack(omnetpp::cCommBuffer *b) const
     doParsimPacking(b,this->MfuId);
     doParsimPacking(b,this->TContId);
     doParsimPacking(b,this->FragmentCount);
+    doParsimPacking(b,this->SequenceNumber);
 }
 
 void ethPacket::parsimUnpack(omnetpp::cCommBuffer *b)
@@ -221,6 +223,7 @@ void ethPacket::parsimUnpack(omnetpp::cCommBuffer *b)
     doParsimUnpacking(b,this->MfuId);
     doParsimUnpacking(b,this->TContId);
     doParsimUnpacking(b,this->FragmentCount);
+    doParsimUnpacking(b,this->SequenceNumber);
 }
 
 omnetpp::simtime_t ethPacket::getGenerationTime() const
@@ -343,6 +346,16 @@ void ethPacket::setFragmentCount(int FragmentCount)
     this->FragmentCount = FragmentCount;
 }
 
+long ethPacket::getSequenceNumber() const
+{
+    return this->SequenceNumber;
+}
+
+void ethPacket::setSequenceNumber(long SequenceNumber)
+{
+    this->SequenceNumber = SequenceNumber;
+}
+
 class ethPacketDescriptor : public omnetpp::cClassDescriptor
 {
   private:
@@ -360,6 +373,7 @@ class ethPacketDescriptor : public omnetpp::cClassDescriptor
         FIELD_MfuId,
         FIELD_TContId,
         FIELD_FragmentCount,
+        FIELD_SequenceNumber,
     };
   public:
     ethPacketDescriptor();
@@ -426,7 +440,7 @@ const char *ethPacketDescriptor::getProperty(const char *propertyName) const
 int ethPacketDescriptor::getFieldCount() const
 {
     omnetpp::cClassDescriptor *base = getBaseClassDescriptor();
-    return base ? 12+base->getFieldCount() : 12;
+    return base ? 13+base->getFieldCount() : 13;
 }
 
 unsigned int ethPacketDescriptor::getFieldTypeFlags(int field) const
@@ -450,8 +464,9 @@ unsigned int ethPacketDescriptor::getFieldTypeFlags(int field) const
         FD_ISEDITABLE,    // FIELD_MfuId
         FD_ISEDITABLE,    // FIELD_TContId
         FD_ISEDITABLE,    // FIELD_FragmentCount
+        FD_ISEDITABLE,    // FIELD_SequenceNumber
     };
-    return (field >= 0 && field < 12) ? fieldTypeFlags[field] : 0;
+    return (field >= 0 && field < 13) ? fieldTypeFlags[field] : 0;
 }
 
 const char *ethPacketDescriptor::getFieldName(int field) const
@@ -475,8 +490,9 @@ const char *ethPacketDescriptor::getFieldName(int field) const
         "MfuId",
         "TContId",
         "FragmentCount",
+        "SequenceNumber",
     };
-    return (field >= 0 && field < 12) ? fieldNames[field] : nullptr;
+    return (field >= 0 && field < 13) ? fieldNames[field] : nullptr;
 }
 
 int ethPacketDescriptor::findField(const char *fieldName) const
@@ -495,6 +511,7 @@ int ethPacketDescriptor::findField(const char *fieldName) const
     if (strcmp(fieldName, "MfuId") == 0) return baseIndex + 9;
     if (strcmp(fieldName, "TContId") == 0) return baseIndex + 10;
     if (strcmp(fieldName, "FragmentCount") == 0) return baseIndex + 11;
+    if (strcmp(fieldName, "SequenceNumber") == 0) return baseIndex + 12;
     return base ? base->findField(fieldName) : -1;
 }
 
@@ -519,8 +536,9 @@ const char *ethPacketDescriptor::getFieldTypeString(int field) const
         "int",    // FIELD_MfuId
         "int",    // FIELD_TContId
         "int",    // FIELD_FragmentCount
+        "long",    // FIELD_SequenceNumber
     };
-    return (field >= 0 && field < 12) ? fieldTypeStrings[field] : nullptr;
+    return (field >= 0 && field < 13) ? fieldTypeStrings[field] : nullptr;
 }
 
 const char **ethPacketDescriptor::getFieldPropertyNames(int field) const
@@ -615,6 +633,7 @@ std::string ethPacketDescriptor::getFieldValueAsString(omnetpp::any_ptr object,
         case FIELD_MfuId: return long2string(pp->getMfuId());
         case FIELD_TContId: return long2string(pp->getTContId());
         case FIELD_FragmentCount: return long2string(pp->getFragmentCount());
+        case FIELD_SequenceNumber: return long2string(pp->getSequenceNumber());
         default: return "";
     }
 }
@@ -643,6 +662,7 @@ void ethPacketDescriptor::setFieldValueAsString(omnetpp::any_ptr object, int fie
         case FIELD_MfuId: pp->setMfuId(string2long(value)); break;
         case FIELD_TContId: pp->setTContId(string2long(value)); break;
         case FIELD_FragmentCount: pp->setFragmentCount(string2long(value)); break;
+        case FIELD_SequenceNumber: pp->setSequenceNumber(string2long(value)); break;
         default: throw omnetpp::cRuntimeError("Cannot set field %d of class 'ethPacket'", field);
     }
 }
@@ -669,6 +689,7 @@ omnetpp::cValue ethPacketDescriptor::getFieldValue(omnetpp::any_ptr object, int
         case FIELD_MfuId: return pp->getMfuId();
         case FIELD_TContId: return pp->getTContId();
         case FIELD_FragmentCount: return pp->getFragmentCount();
+        case FIELD_SequenceNumber: return (omnetpp::intval_t)(pp->getSequenceNumber());
         default: throw omnetpp::cRuntimeError("Cannot return field %d of class 'ethPacket' as cValue -- field index out of range?", field);
     }
 }
@@ -697,6 +718,7 @@ void ethPacketDescriptor::setFieldValue(omnetpp::any_ptr object, int field, int
         case FIELD_MfuId: pp->setMfuId(omnetpp::checked_int_cast<int>(value.intValue())); break;
         case FIELD_TContId: pp->setTContId(omnetpp::checked_int_cast<int>(value.intValue())); break;
         case FIELD_FragmentCount: pp->setFragmentCount(omnetpp::checked_int_cast<int>(value.intValue())); break;
+        case FIELD_SequenceNumber: pp->setSequenceNumber(omnetpp::checked_int_cast<long>(value.intValue())); break;
         default: throw omnetpp::cRuntimeError("Cannot set field %d of class 'ethPacket'", field);
     }
 }
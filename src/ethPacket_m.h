@@ -36,6 +36,7 @@ class ethPacket;
  *     int MfuId;
  *     int TContId;						// T-CONT type
  *     int FragmentCount = 0;				// id of fragmented packet
+ *     long SequenceNumber = 0;			// unique per acquire() from the packet pool, keys the reassembly
  * }
  * </pre>
  */
@@ -54,6 +55,7 @@ class ethPacket : public ::omnetpp::cPacket
     int MfuId = 0;
     int TContId = 0;
     int FragmentCount = 0;
+    long SequenceNumber = 0;
 
   private:
     void copy(const ethPacket& other);
@@ -105,6 +107,9 @@ class ethPacket : public ::omnetpp::cPacket
 
     virtual int getFragmentCount() const;
     virtual void setFragmentCount(int FragmentCount);
+
+    virtual long getSequenceNumber() const;
+    virtual void setSequenceNumber(long SequenceNumber);
 };
 
 inline void doParsimPacking(omnetpp::cCommBuffer *b, const ethPacket& obj) {obj.parsimPack(b);}
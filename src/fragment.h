@@ -0,0 +1,69 @@
+/*
+ * fragment.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef FRAGMENT_H_
+#define FRAGMENT_H_
+
+#include <omnetpp.h>
+
+#include "msg_kinds.h"
+
+using namespace omnetpp;
+
+/*
+ * Fragment descriptor sent when a grant ends in the middle of a queued packet.
+ * The packet itself stays at the head of its T-CONT queue, with the bytes
+ * already sent kept as an offset by the ONU/SFU, until its last bytes go out as
+ * the packet itself. The descriptor only carries what the OLT needs for the
+ * reassembly: the sequence number of the packet, the fragment index and the byte offset.
+ * A fragment cut at the SFU may be cut again at the ONU; the pieces keep the
+ * sequence number of the original packet and the index of the SFU fragment,
+ * so several descriptors can share an index and are told apart by their offset.
+ * Unlike the message id the sequence number is never reused by a recycled
+ * packet and survives a parsim partition boundary.
+ */
+class ethFragment : public cPacket
+{
+    private:
+        long packet_id = -1;            // sequence number of the fragmented ethPacket
+        int index = 0;                  // fragment index in the packet, starting at 1, shared by pieces of a re-cut fragment
+        long offset = 0;                // bytes of the queued piece sent before this fragment
+        int tcont_id = 0;               // T-CONT of the packet, for queueing at the ONU
+
+    public:
+        ethFragment(const char *name=nullptr, short kind=ETH_FRAGMENT) : cPacket(name, kind) {}
+        ethFragment(const ethFragment& other) : cPacket(other), packet_id(other.packet_id), index(other.index),
+                                                offset(other.offset), tcont_id(other.tcont_id) {}
+        virtual ethFragment *dup() const override { return new ethFragment(*this); }
+
+        // with parsim the descriptor crosses the 50G-PON partition boundary
+        virtual void parsimPack(cCommBuffer *buffer) const override {
+            cPacket::parsimPack(buffer);
+            buffer->pack(packet_id);
+            buffer->pack(index);
+            buffer->pack(offset);
+            buffer->pack(tcont_id);
+        }
+        virtual void parsimUnpack(cCommBuffer *buffer) override {
+            cPacket::parsimUnpack(buffer);
+            buffer->unpack(packet_id);
+            buffer->unpack(index);
+            buffer->unpack(offset);
+            buffer->unpack(tcont_id);
+        }
+
+        long getPacketId() const { return packet_id; }
+        void setPacketId(long id) { packet_id = id; }
+        int getIndex() const { return index; }
+        void setIndex(int i) { index = i; }
+        long getOffset() const { return offset; }
+        void setOffset(long o) { offset = o; }
+        int getTContId() const { return tcont_id; }
+        void setTContId(int id) { tcont_id = id; }
+};
+
+#endif /* FRAGMENT_H_ */
@@ -0,0 +1,162 @@
+/*
+ * hdr_histogram.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include <math.h>
+#include <sstream>
+#include <algorithm>
+
+#include "hdr_histogram.h"
+
+using namespace std;
+
+Register_ResultRecorder("hdrHistogram", HdrHistogramRecorder);
+
+LogHistogram::LogHistogram(double unit, int sub_bits, int range_bits) : unit(unit), sub_bits(sub_bits)
+{
+    sub_count = 1LL << sub_bits;
+    half_count = sub_count/2;
+    counts.assign(sub_count + (range_bits - sub_bits + 1)*half_count, 0);
+}
+
+int LogHistogram::indexOf(long long v) const
+{
+    if(v < sub_count)
+        return (int)v;                          // one bucket per unit
+    int top_bit = 63 - __builtin_clzll(v);
+    int shift = top_bit - (sub_bits - 1);       // >= 1
+    long long sub = v >> shift;                 // in [half_count, sub_count)
+    return (int)(sub_count + (shift - 1)*half_count + (sub - half_count));
+}
+
+double LogHistogram::valueOf(int index) const
+{
+    if(index < sub_count)
+        return index;
+    long long k = index - sub_count;
+    int shift = (int)(k/half_count) + 1;
+    long long sub = k%half_count + half_count;
+    return (double)(sub << shift) + (double)(1LL << shift)/2;
+}
+
+void LogHistogram::collect(double value)
+{
+    if(total == 0 || value < min_value)
+        min_value = value;
+    if(total == 0 || value > max_value)
+        max_value = value;
+    total++;
+    sum += value;
+
+    long long v = (value > 0) ? llround(value/unit) : 0;
+    int index = indexOf(v);
+    if(index >= (int)counts.size())
+        index = counts.size() - 1;              // beyond the range, counted in the last bucket
+    counts[index]++;
+}
+
+void LogHistogram::merge(const LogHistogram& other)
+{
+    if((other.unit != unit) || (other.counts.size() != counts.size()))
+        throw cRuntimeError("LogHistogram::merge(): histograms have different layouts");
+    if(other.total == 0)
+        return;
+
+    for(size_t i = 0; i < counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+    min_value = (total == 0) ? other.min_value : std::min(min_value, other.min_value);
+    max_value = (total == 0) ? other.max_value : std::max(max_value, other.max_value);
+    total += other.total;
+    sum += other.sum;
+}
+
+void LogHistogram::clear()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    min_value = 0;
+    max_value = 0;
+    sum = 0;
+}
+
+double LogHistogram::getQuantile(double q) const
+{
+    if(total == 0)
+        return NAN;
+
+    long long rank = (long long)ceil(q*total);
+    if(rank < 1)
+        rank = 1;
+    long long seen = 0;
+    for(size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if(seen >= rank) {
+            double value = valueOf(i)*unit;
+            return std::min(std::max(value, min_value), max_value);      // the extremes are known exactly
+        }
+    }
+    return max_value;
+}
+
+string LogHistogram::toString() const
+{
+    ostringstream out;
+    for(size_t i = 0; i < counts.size(); i++) {
+        if(counts[i] > 0)
+            out << i << ":" << counts[i] << " ";
+    }
+    return out.str();
+}
+
+void LogHistogram::fromString(const string& text)
+{
+    istringstream in(text);
+    string pair;
+    while(in >> pair) {
+        size_t colon = pair.find(':');
+        long index = stol(pair.substr(0, colon));
+        long long count = stoll(pair.substr(colon + 1));
+        if((index < 0) || (index >= (long)counts.size()))
+            throw cRuntimeError("LogHistogram::fromString(): bucket %ld out of range", index);
+        counts[index] += count;
+        double value = valueOf(index)*unit;
+        if(total == 0 || value < min_value)
+            min_value = value;
+        if(total == 0 || value > max_value)
+            max_value = value;
+        total += count;
+        sum += count*value;
+    }
+}
+
+void LogHistogram::recordScalars(cComponent *component, const string& name) const
+{
+    opp_string_map attributes;
+    attributes["hdr"] = toString();
+    attributes["hdr_layout"] = opp_stringf("%g %d", unit, sub_bits);     // count unit and sub-bucket bits, to map the buckets back to values
+    getEnvir()->recordScalar(component, (name + ":count").c_str(), total, &attributes);
+    if(total == 0)
+        return;
+
+    getEnvir()->recordScalar(component, (name + ":mean").c_str(), getMean());
+    getEnvir()->recordScalar(component, (name + ":min").c_str(), min_value);
+    getEnvir()->recordScalar(component, (name + ":max").c_str(), max_value);
+    getEnvir()->recordScalar(component, (name + ":p50").c_str(), getQuantile(0.5));
+    getEnvir()->recordScalar(component, (name + ":p99").c_str(), getQuantile(0.99));
+    getEnvir()->recordScalar(component, (name + ":p99.9").c_str(), getQuantile(0.999));
+    getEnvir()->recordScalar(component, (name + ":p99.99").c_str(), getQuantile(0.9999));
+}
+
+void HdrHistogramRecorder::collect(simtime_t_cref t, double value, cObject *details)
+{
+    histogram.collect(value);
+}
+
+void HdrHistogramRecorder::finish(cResultFilter *prev)
+{
+    histogram.recordScalars(getComponent(), getStatisticName());
+}
@@ -0,0 +1,81 @@
+/*
+ * hdr_histogram.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef HDR_HISTOGRAM_H_
+#define HDR_HISTOGRAM_H_
+
+#include <string>
+#include <vector>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/*
+ * Log-bucketed histogram in the style of HdrHistogram. Values are counted in
+ * integer units (1 ns by default). Below 2^sub_bits units every unit has its
+ * own bucket. Above that every power of two is split into 2^(sub_bits-1)
+ * buckets, so a quantile is within 2^-(sub_bits-1) of the true value (0.2% for
+ * sub_bits = 10). Memory is fixed when the histogram is created. Two
+ * histograms with the same layout can be merged by adding the counts.
+ */
+class LogHistogram
+{
+    private:
+        double unit;                            // value of one count unit
+        int sub_bits;
+        long long sub_count;                    // 2^sub_bits
+        long long half_count;                   // 2^(sub_bits-1)
+        std::vector<long long> counts;
+        long long total = 0;
+        double min_value = 0;
+        double max_value = 0;
+        double sum = 0;
+
+        int indexOf(long long v) const;
+        double valueOf(int index) const;        // middle of the bucket, in units
+
+    public:
+        LogHistogram(double unit = 1e-9, int sub_bits = 10, int range_bits = 40);
+
+        void collect(double value);
+        void merge(const LogHistogram& other);
+        void clear();                           // forget all values, the layout is kept
+        double getQuantile(double q) const;     // 0 < q <= 1
+
+        long long getCount() const { return total; }
+        double getMin() const { return min_value; }
+        double getMax() const { return max_value; }
+        double getMean() const { return (total > 0) ? sum/total : 0; }
+
+        // non-empty buckets as "index:count" pairs, enough to merge replications offline
+        std::string toString() const;
+        void fromString(const std::string& text);
+
+        // count (with the buckets as attribute), mean, min, max and the tail quantiles as "<name>:<field>" scalars
+        void recordScalars(cComponent *component, const std::string& name) const;
+};
+
+/*
+ * Result recorder collecting a signal into a LogHistogram. It only writes
+ * scalars at the end of the run: count, mean, min, max and the P50, P99, P99.9
+ * and P99.99 quantiles. The bucket counts go into the "hdr" attribute of the
+ * count scalar, so replications can be merged later. Select it in NED with
+ * record=hdrHistogram.
+ */
+class HdrHistogramRecorder : public cNumericResultRecorder
+{
+    protected:
+        LogHistogram histogram;
+
+        virtual void collect(simtime_t_cref t, double value, cObject *details) override;
+        virtual void finish(cResultFilter *prev) override;
+
+    public:
+        const LogHistogram& getHistogram() const { return histogram; }
+};
+
+#endif /* HDR_HISTOGRAM_H_ */
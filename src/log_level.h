@@ -0,0 +1,31 @@
+/*
+ * log_level.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef LOG_LEVEL_H_
+#define LOG_LEVEL_H_
+
+#include <omnetpp.h>
+
+/*
+ * Compile-time log level of the model. EV statements below it are removed by
+ * the compiler, including the evaluation of their arguments; cmdenv-log-level
+ * can only filter what is compiled in. Per-packet lines use EV_TRACE, per-cycle
+ * lines EV_DEBUG and everything else EV (info). Release builds (NDEBUG) keep
+ * info and above, other levels can be set with -DFTTR_LOGLEVEL=omnetpp::LOGLEVEL_...
+ */
+#ifndef FTTR_LOGLEVEL
+#ifdef NDEBUG
+#define FTTR_LOGLEVEL omnetpp::LOGLEVEL_INFO
+#else
+#define FTTR_LOGLEVEL omnetpp::LOGLEVEL_TRACE
+#endif
+#endif
+
+#undef COMPILETIME_LOGLEVEL
+#define COMPILETIME_LOGLEVEL FTTR_LOGLEVEL
+
+#endif /* LOG_LEVEL_H_ */
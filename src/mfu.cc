@@ -15,11 +15,16 @@
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
+#include "bw_map.h"
+#include "dba.h"
+#include "fragment.h"
 
 using namespace std;
 using namespace omnetpp;
 
-class MFU : public cSimpleModule
+class MFU : public cSimpleModule, public cListener
 {
     private:
         vector<double> sfu_rtt;
@@ -27,25 +32,32 @@ class MFU : public cSimpleModule
         vector<double> sfu_buffer_TC2;
         vector<double> sfu_buffer_TC3;
         vector<double> sfu_grant_TC1;
-        vector<double> sfu_grant_TC2;
-        vector<double> sfu_grant_TC3;
         vector<double> sfu_start_time_TC1;
-        vector<double> sfu_start_time_TC2;
-        vector<double> sfu_start_time_TC3;
         vector<int> sfu_index;
         vector<double> sfu_tx_start_TC1;
         vector<double> sfu_tx_start_TC2;
         vector<double> sfu_tx_start_TC3;
         long seqID = 0;
 
+        cMessage *schedule_dl_gtc = nullptr;            // self-messages owned by the MFU, re-armed every cycle
+        cMessage *send_dl_payload = nullptr;
+        long timer_allocs_avoided = 0;                  // self-message allocations saved by re-arming the timers
+
         int sfus;
         int ping_count = 0;
         double sfu_max_grant;
+        DBA *dba = nullptr;                             // grant policy, selected by the dbaPolicy parameter
+
+        bool skip_idle_cycles;                          // stop the cycle timer while every report is empty
+        bool suspended = false;
+        simtime_t suspend_time;                         // last cycle before the timer was stopped
+        long idle_cycles_skipped = 0;
+        simsignal_t stats_reset = SIMSIGNAL_NULL;       // emitted on this module by the OLT when it forks branches
 
         //simsignal_t errorSignal;
 
     public:
-        //virtual ~MFU();
+        virtual ~MFU();
 
     protected:
         double ber;
@@ -56,17 +68,36 @@ class MFU : public cSimpleModule
         // The following redefined virtual function holds the algorithm.
         virtual void initialize() override;
         virtual void handleMessage(cMessage *msg) override;
+        virtual void finish() override;
+        virtual void resumeCycles();
+        virtual void handleParameterChange(const char *parname) override;
+        virtual void receiveSignal(cComponent *source, simsignal_t signal, bool b, cObject *details) override;
         //virtual ponPacket *generateGrantPacket();
 };
 
 Define_Module(MFU);
 
+MFU::~MFU()
+{
+    if((stats_reset != SIMSIGNAL_NULL) && isSubscribed(stats_reset, this))
+        unsubscribe(stats_reset, this);           // the cListener base goes before the module
+    cancelAndDelete(schedule_dl_gtc);
+    cancelAndDelete(send_dl_payload);
+    delete dba;
+}
+
 void MFU::initialize()
 {
     //errorSignal = registerSignal("pkt_error");  // registering the signal
 
     gate("SpltGate_i")->setDeliverImmediately(true);
 
+    schedule_dl_gtc = new cMessage("schedule_dl_gtc", SCHEDULE_DL_GTC);
+    send_dl_payload = new cMessage("send_dl_payload", SEND_DL_PAYLOAD);    // send downlink data
+    skip_idle_cycles = par("skipIdleCycles");
+    stats_reset = registerSignal("statsReset");
+    subscribe(stats_reset, this);
+
     sfus = par("NumberOfSFUs");
     EV << getFullName() << " No. of sfus detected = " << sfus << endl;
 
@@ -75,11 +106,7 @@ void MFU::initialize()
     sfu_buffer_TC2.resize(sfus,0.0);
     sfu_buffer_TC3.resize(sfus,0.0);
     sfu_grant_TC1.resize(sfus,0.0);
-    sfu_grant_TC2.resize(sfus,0.0);
-    sfu_grant_TC3.resize(sfus,0.0);
     sfu_start_time_TC1.resize(sfus,0.0);
-    sfu_start_time_TC2.resize(sfus,0.0);
-    sfu_start_time_TC3.resize(sfus,0.0);
 
     for(int j = 0; j<sfus; j++) {
         sfu_index.push_back(j);
@@ -88,62 +115,38 @@ void MFU::initialize()
     //EV << "[mfu" << getIndex() << "] onu_rtt[0] = " << onu_rtt[0] << ", onu_rtt[1] = " << onu_rtt[1] << endl;
     // bw_map = [onu_id, tc_type, start_time, grant_size]
 
-    ping *png = new ping("ping");      // sending ping message at T = 0 for finding the RTT of all SFUs
+    ping *png = new ping("ping", PING);      // sending ping message at T = 0 for finding the RTT of all SFUs
     send(png,"SpltGate_o");
     EV << getFullName() << " Sending ping from MFU at = " << simTime() << endl;
 }
 
 void MFU::handleMessage(cMessage *msg)
 {
-    if(msg->isPacket() == true) {
-        if(strcmp(msg->getName(),"gtc_hdr_ul") == 0) {        // updating buffer size after receiving requests from SFUs
+    switch(msg->getKind()) {
+        case GTC_HDR_UL: {        // updating buffer size after receiving requests from SFUs
             gtc_header *pkt = check_and_cast<gtc_header *>(msg);
 
             int sfuId = pkt->getSfuID();
             int index = sfuId % sfus;
             // for T-CONT 2
             sfu_buffer_TC2[index] = pkt->getBufferOccupancyTC2();
-            EV << getFullName() << " updated sfu_buffer_TC2[" << index << "] = " << sfu_buffer_TC2[index] << " for sfuId = " << sfuId <<endl;
+            EV_DEBUG << getFullName() << " updated sfu_buffer_TC2[" << index << "] = " << sfu_buffer_TC2[index] << " for sfuId = " << sfuId <<endl;
             // for T-CONT 3
             sfu_buffer_TC3[index] = pkt->getBufferOccupancyTC3();
-            EV << getFullName() << " updated sfu_buffer_TC3[" << index << "] = " << sfu_buffer_TC3[index] << " for sfuId = " << sfuId << endl;
-
-            delete pkt;         // nothing more to do with the header
-        }
-        else if(strcmp(msg->getName(),"bkg_data") == 0) {        // updating buffer size after receiving requests from SFUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            int sfuId = pkt->getSfuId();
-            int tcId = pkt->getTContId();
-            pkt->setMfuId(getIndex());
-            pkt->setSfuId(sfuId);
-            send(pkt,"OnuGate_out");                     // just forward to ONU
-
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"xr_data") == 0) {        // updating buffer size after receiving requests from SFUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            int sfuId = pkt->getSfuId();
-            int tcId = pkt->getTContId();
-            pkt->setMfuId(getIndex());
-            pkt->setSfuId(sfuId);
-            send(pkt,"OnuGate_out");                     // just forward to ONU
-
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"hmd_data") == 0) {        // updating buffer size after receiving requests from SFUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
+            EV_DEBUG << getFullName() << " updated sfu_buffer_TC3[" << index << "] = " << sfu_buffer_TC3[index] << " for sfuId = " << sfuId << endl;
 
-            int sfuId = pkt->getSfuId();
-            int tcId = pkt->getTContId();
-            pkt->setMfuId(getIndex());
-            pkt->setSfuId(sfuId);
-            send(pkt,"OnuGate_out");                     // just forward to ONU
+            if(suspended && ((sfu_buffer_TC2[index] > 0) || (sfu_buffer_TC3[index] > 0))) {
+                resumeCycles();             // new data reported, back to one map per cycle
+            }
 
-            //delete pkt;
+            delete pkt;         // nothing more to do with the header
+            break;
         }
-        else if(strcmp(msg->getName(),"control_data") == 0) {        // updating buffer size after receiving requests from SFUs
+        case BKG_DATA:
+        case XR_DATA:
+        case HMD_DATA:
+        case CONTROL_DATA:
+        case HAPTIC_DATA: {        // data from SFUs of all traffic classes
             ethPacket *pkt = check_and_cast<ethPacket *>(msg);
 
             int sfuId = pkt->getSfuId();
@@ -153,21 +156,13 @@ void MFU::handleMessage(cMessage *msg)
             send(pkt,"OnuGate_out");                     // just forward to ONU
 
             //delete pkt;
+            break;
         }
-        else if(strcmp(msg->getName(),"haptic_data") == 0) {        // updating buffer size after receiving requests from SFUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            int sfuId = pkt->getSfuId();
-            int tcId = pkt->getTContId();
-            pkt->setMfuId(getIndex());
-            pkt->setSfuId(sfuId);
-            send(pkt,"OnuGate_out");                     // just forward to ONU
-
-            //delete pkt;
+        case ETH_FRAGMENT: {       // fragment descriptors are forwarded like the packets they belong to
+            send(msg,"OnuGate_out");
+            break;
         }
-    }
-    else {
-        if(strcmp(msg->getName(),"ping") == 0) {
+        case PING: {
             ping_count += 1;
             ping *png = check_and_cast<ping *>(msg);
             int sfu_id = png->getSFU_id();
@@ -181,22 +176,25 @@ void MFU::handleMessage(cMessage *msg)
 
             if(ping_count == sfus) {
                 //EV << getFullName() << " onu_total_latency[0] = " << onu_total_latency[0] << ", onu_total_latency[1] = " << onu_total_latency[1] << endl;
-                cMessage *schedule_dl_gtc = new cMessage("schedule_dl_gtc");
                 scheduleAt(simTime(), schedule_dl_gtc);           // when ping from all SFUs arrive, initiate the grant scheduling process
 
                 sfu_max_grant = floor((max_polling_cycle - T_guard*sfus)*(int_pon_link_datarate/sfus)/8);  // in Bytes
                 //EV << getFullName() << " worst_rtt = " << worst_rtt << ", onu_max_grant = " << onu_max_grant << endl;
                 for(int i = 0;i<sfus;i++) {
-                    sfu_grant_TC3[i]  = sfu_max_grant;       // initializing all SFUs with maximum grant value
-                    sfu_buffer_TC3[i] = sfu_max_grant;
+                    sfu_buffer_TC3[i] = sfu_max_grant;       // initializing all SFUs with maximum grant value
                 }
+
+                delete dba;
+                dba = DBA::create(par("dbaPolicy"), sfus, sfu_max_grant, int_pon_link_datarate);
+                EV << getFullName() << " DBA policy = " << dba->getPolicyName() << endl;
             }
             delete png;
+            break;
         }
-        else if(strcmp(msg->getName(),"schedule_dl_gtc") == 0) {        // calculating the time-instants for sending grants to sfus
+        case SCHEDULE_DL_GTC: {        // calculating the time-instants for sending grants to sfus
             scheduleAt(simTime()+(simtime_t)125e-6, msg);                          // schedule the self-message after 125 usec
 
-            gtc_header *gtc_hdr_dl = new gtc_header("gtc_hdr_dl");
+            gtc_dl_header *gtc_hdr_dl = new gtc_dl_header("gtc_hdr_dl", GTC_HDR_DL);
             gtc_hdr_dl->setMfuID(getIndex());
             double us_bw_map_sz = sfus*8;                                  // (N x 8) Bytes
             double gtc_hdr_sz = 4 + 4 + 13 + 1 + (4*2) + us_bw_map_sz;     // total size of GTC DL header
@@ -205,56 +203,102 @@ void MFU::handleMessage(cMessage *msg)
             gtc_hdr_dl->setDownlink(true);
             gtc_hdr_dl->setInt_pon(true);
             gtc_hdr_dl->setSeqID(++seqID);
-            gtc_hdr_dl->setMfu_sfu_rttArraySize(sfus);
-            for (int i = 0; i < sfus; ++i) {
-                gtc_hdr_dl->setMfu_sfu_rtt(i, sfu_rtt[i]);
-            }
-
-            gtc_hdr_dl->setSfu_start_time_TC2ArraySize(sfus);
-            gtc_hdr_dl->setSfu_grant_TC2ArraySize(sfus);
-            gtc_hdr_dl->setSfu_start_time_TC3ArraySize(sfus);
-            gtc_hdr_dl->setSfu_grant_TC3ArraySize(sfus);
 
             double worst_rtt = *std::max_element(sfu_rtt.begin(), sfu_rtt.end());
-            double tx_start = 0;
+            BandwidthMap *bw_map = dba->schedule(sfu_rtt, sfu_buffer_TC2, sfu_buffer_TC3);      // grants of this cycle from the selected policy
 
             for(int i = 0;i<sfus;i++) {
-                double sfu_max_grant_TC2 = (sfu_buffer_TC2[i]/(sfu_buffer_TC2[i]+sfu_buffer_TC3[i]))*sfu_max_grant;
-                double sfu_max_grant_TC3 = (1-(sfu_buffer_TC2[i]/(sfu_buffer_TC2[i]+sfu_buffer_TC3[i])))*sfu_max_grant;
-
-                sfu_grant_TC2[i] = std::min(sfu_buffer_TC2[i], sfu_max_grant_TC2);      // granting BW using limited service policy
-                sfu_grant_TC3[i] = std::min(sfu_buffer_TC3[i], sfu_max_grant_TC3);
-                //sfu_grant_TC2[i] = sfu_max_grant/2;                             // granting BW using fixed service policy
-                //sfu_grant_TC3[i] = sfu_max_grant/2;
-
-                // filling into the header packet for T-CONT 2
-                sfu_start_time_TC2[i] = tx_start + T_guard;
-                gtc_hdr_dl->setSfu_start_time_TC2(i, sfu_start_time_TC2[i]);
-                gtc_hdr_dl->setSfu_grant_TC2(i, sfu_grant_TC2[i]);
-                // filling into the header packet for T-CONT 3
-                sfu_start_time_TC3[i] = tx_start + T_guard + (sfu_grant_TC2[i]*8/int_pon_link_datarate);
-                gtc_hdr_dl->setSfu_start_time_TC3(i, sfu_start_time_TC3[i]);
-                gtc_hdr_dl->setSfu_grant_TC3(i, sfu_grant_TC3[i]);
-                // shifting the tx_start cursor
-                tx_start += T_guard + (sfu_grant_TC2[i]*8/int_pon_link_datarate) + (sfu_grant_TC3[i]*8/int_pon_link_datarate);
-
-                EV << getFullName() << " sfu_start_time_TC2[" << i << "] = " << simTime().dbl()+max_polling_cycle+sfu_start_time_TC2[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
-                EV << getFullName() << " sfu_start_time_TC3[" << i << "] = " << simTime().dbl()+max_polling_cycle+sfu_start_time_TC3[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
+                EV_DEBUG << getFullName() << " sfu_start_time_TC2[" << i << "] = " << simTime().dbl()+bw_map->tx_offset+bw_map->start_time_TC2[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
+                EV_DEBUG << getFullName() << " sfu_start_time_TC3[" << i << "] = " << simTime().dbl()+bw_map->tx_offset+bw_map->start_time_TC3[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
+            }
+            EV_DEBUG << getFullName() << " last SFU tx finish time = " << simTime().dbl()+bw_map->tx_offset+bw_map->start_time_TC3[sfus-1]-(worst_rtt/2)+(bw_map->grant_TC3[sfus-1]*8/int_pon_link_datarate) << " for seqID = " << seqID << endl;
+
+            if(skip_idle_cycles && dba->isIdle(sfu_buffer_TC2, sfu_buffer_TC3, bw_map)) {
+                bw_map->standing = true;        // the SFUs keep using this map until the next one
+                cancelEvent(msg);
+                suspended = true;
+                suspend_time = simTime();
+                EV << getFullName() << " all SFUs idle, cycle timer stopped after seqID = " << seqID << endl;
             }
-            EV << getFullName() << " last SFU tx finish time = " << simTime().dbl()+max_polling_cycle+sfu_start_time_TC3[sfus-1]-(worst_rtt/2)+(sfu_grant_TC3[sfus-1]*8/int_pon_link_datarate) << " for seqID = " << seqID << endl;
+
+            // the bandwidth map is shared by all copies of the header
+            gtc_hdr_dl->setBwMap(std::shared_ptr<const BandwidthMap>(bw_map));
 
             send(gtc_hdr_dl,"SpltGate_o");          // sending the downlink GTC header to SFUs
 
-            cMessage *send_dl_payload = new cMessage("send_dl_payload");    // send downlink data
             scheduleAt(simTime(), send_dl_payload);
-
+            timer_allocs_avoided++;
+            break;
         }
-        else if(strcmp(msg->getName(),"send_dl_payload") == 0) {        // sending the downlink GTC header to SFUs
-            delete msg;         // not doing anything now, just keeping the provision for future
+        case SEND_DL_PAYLOAD: {        // sending the downlink GTC header to SFUs
+            // not doing anything now, just keeping the provision for future
+            break;
         }
+        default:
+            EV << getFullName() << " Some unknown cMessage has arrived at = " << simTime() << endl;
+            delete msg;
+            break;
     }
 }
 
+void MFU::finish()
+{
+    // every re-arm of send_dl_payload used to be a fresh cMessage allocation
+    recordScalar("timer allocations avoided", timer_allocs_avoided);
+    if(simTime() > 0)
+        recordScalar("timer allocations avoided per second", timer_allocs_avoided/simTime().dbl());
+
+    recordScalar("idle cycles skipped", idle_cycles_skipped);
+    if(dba != nullptr) {
+        recordScalar("upstream grant utilization", dba->getUtilization());      // granted share of the upstream capacity
+        recordScalar("redistributed excess share", dba->getRedistributedShare());   // part of the grants taken from lightly loaded units
+    }
+}
 
+/*
+ * Restarts the cycle timer at the first cycle boundary not before now, so the
+ * phase is the same as if the timer had kept running. The skipped cycles would
+ * all have carried the standing map and are only counted.
+ */
+void MFU::resumeCycles()
+{
+    simtime_t next_cycle = suspend_time + (simtime_t)125e-6;
+    long skipped = 0;
+    while(next_cycle < simTime()) {
+        next_cycle += (simtime_t)125e-6;
+        skipped++;
+    }
+    seqID += skipped;
+    dba->skipCycles(skipped);
+    idle_cycles_skipped += skipped;
+    suspended = false;
+
+    scheduleAt(next_cycle, schedule_dl_gtc);
+    EV << getFullName() << " cycle timer resumed at " << next_cycle << " after " << skipped << " idle cycles" << endl;
+}
 
+/*
+ * dbaPolicy may change while the simulation runs, e.g. in a branch forked by
+ * the OLT. The new policy starts with fresh utilization counters.
+ */
+void MFU::handleParameterChange(const char *parname)
+{
+    if((strcmp(parname, "dbaPolicy") == 0) && (dba != nullptr)) {
+        delete dba;
+        dba = DBA::create(par("dbaPolicy"), sfus, sfu_max_grant, int_pon_link_datarate);
+        EV << getFullName() << " DBA policy changed to " << dba->getPolicyName() << " at " << simTime() << endl;
+    }
+}
 
+/*
+ * statsReset: a forked branch starts here, the grant utilization and idle
+ * cycle counts of the common part before the fork are forgotten.
+ */
+void MFU::receiveSignal(cComponent *source, simsignal_t signal, bool b, cObject *details)
+{
+    if(signal != stats_reset)
+        return;
+    idle_cycles_skipped = 0;
+    if(dba != nullptr)
+        dba->resetCounters();
+}
@@ -0,0 +1,45 @@
+/*
+ * msg_kinds.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef MSG_KINDS_H_
+#define MSG_KINDS_H_
+
+/*
+ * Message kinds shared by all modules. Every packet and self-message gets its
+ * kind via setKind() when it is created, so that handleMessage() can dispatch
+ * with a switch instead of comparing message names. dup() keeps the kind.
+ * Kind 0 (the cMessage default) is deliberately left unused.
+ */
+enum MsgKind {
+    // control messages
+    PING = 1,                   // ranging message from OLT/MFU
+    GTC_HDR_DL,                 // downlink GTC header (bandwidth map)
+    GTC_HDR_UL,                 // uplink GTC header (buffer report)
+
+    // data packets
+    BKG_DATA,                   // background traffic (T-CONT 3)
+    XR_DATA,                    // XR traffic (T-CONT 2)
+    HMD_DATA,                   // HMD traffic (T-CONT 2)
+    CONTROL_DATA,               // control traffic (T-CONT 2)
+    HAPTIC_DATA,                // haptic traffic (T-CONT 2)
+    ETH_FRAGMENT,               // fragment descriptor of a packet split over two grants
+
+    // self-messages
+    SCHEDULE_DL_GTC,            // OLT/MFU polling cycle
+    FORK_RUN,                   // OLT forks the warmed-up network into branches
+    SEND_DL_PAYLOAD,            // OLT/MFU downlink payload (placeholder)
+    SEND_UL_HEADER,             // ONU/SFU uplink header transmission
+    SEND_UL_PAYLOAD_TC2,        // ONU/SFU T-CONT 2 payload transmission
+    SEND_UL_PAYLOAD_TC3,        // ONU/SFU T-CONT 3 payload transmission
+    SEND_UL_STANDING,           // ONU/SFU report in a cycle skipped by an idle OLT/MFU
+    OLT_TX_DELAY,               // splitter upstream queue timer
+    ONU_TX_DELAY,               // splitter downstream queue timer
+    GENERATE_EVENT,             // source packet generation
+    SEND_EVENT                  // source wireless transmission finished
+};
+
+#endif /* MSG_KINDS_H_ */
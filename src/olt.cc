@@ -10,15 +10,38 @@
 #include <omnetpp.h>
 #include <numeric>   // Required for std::iota
 #include <algorithm> // Required for std::sort
+#include <unordered_map>
+#include <errno.h>
+#include <stdint.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
 
 #include "sim_params.h"
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
+#include "packet_pool.h"
+#include "bw_map.h"
+#include "dba.h"
+#include "fragment.h"
+#include "hdr_histogram.h"
+#include "warmup.h"
+#include "stopping_rule.h"
 
 using namespace std;
 using namespace omnetpp;
 
+// the hops of the upstream path, in the order a packet passes them
+enum Hop { WIRELESS, WAP, SFU_QUEUE, PON10G_UP, ONU_QUEUE, PON50G_UP, HOPS };
+static const char *hop_names[HOPS] = {"wireless", "wap", "sfu_queue", "pon10g_up", "onu_queue", "pon50g_up"};
+static const char *class_names[] = {"bkg", "xr", "hmd", "ctrl", "hptc"};     // in the order of the data message kinds
+static const int CLASSES = HAPTIC_DATA - BKG_DATA + 1;
+
 class OLT : public cSimpleModule
 {
     private:
@@ -28,30 +51,62 @@ class OLT : public cSimpleModule
         vector<double> onu_buffer_TC2;
         vector<double> onu_buffer_TC3;
         vector<double> onu_grant_TC1;
-        vector<double> onu_grant_TC2;
-        vector<double> onu_grant_TC3;
         vector<double> onu_start_time_TC1;
-        vector<double> onu_start_time_TC2;
-        vector<double> onu_start_time_TC3;
         vector<int> onu_index;
         vector<double> onu_tx_start_TC1;
         vector<double> onu_tx_start_TC2;
         vector<double> onu_tx_start_TC3;
         long seqID = 0;
 
+        cMessage *schedule_dl_gtc = nullptr;            // self-messages owned by the OLT, re-armed every cycle
+        cMessage *send_dl_payload = nullptr;
+        long timer_allocs_avoided = 0;                  // self-message allocations saved by re-arming the timers
+
         int onus;
         int ping_count = 0;
         double onu_max_grant;
+        DBA *dba = nullptr;                             // grant policy, selected by the dbaPolicy parameter
+
+        bool skip_idle_cycles;                          // stop the cycle timer while every report is empty
+        bool suspended = false;
+        simtime_t suspend_time;                         // last cycle before the timer was stopped
+        long idle_cycles_skipped = 0;
+
+        struct Reassembly {
+            long bytes = 0;                             // received so far
+            uint64_t indices = 0;                       // bit i set when fragment index i arrived
+            simtime_t first_fragment;
+        };
+        unordered_map<long, Reassembly> reassembly;     // per sequence number of a fragmented packet
+        simtime_t reassembly_timeout;                   // entries older than this are dropped, their packet was lost
+        simtime_t next_reassembly_sweep;
+        long reassembly_timeouts = 0;
+        long reassembly_mismatches = 0;                 // fragment indices not matching the fragment count of the packet
+        long fragments_received = 0;
+        long packets_reassembled = 0;
+        long reassembly_errors = 0;                     // fragmented packets arriving without their fragments
+
+        bool record_hop_latency;                        // split the latency of measured packets per hop
+        vector<vector<LogHistogram>> hop_latency;       // [traffic class][hop]
+
+        vector<bool> onu_scope;                         // ONUs whose packets are measured, empty for all
+        vector<bool> sfu_scope;                         // SFUs whose packets are measured, empty for all
+        double measure_fraction;                        // share of the packets in scope that is measured
+        double sample_phase = 0;
+        vector<LogHistogram> flow_latency;              // flat flow table, [onu*CLASSES + class]
+        vector<MserDetector> warmup;                    // per class, empty when the warm-up is not detected
+        BatchMeansStopper *stopper = nullptr;           // ends the run once the stopMetric interval is narrow enough
+        int stop_class = -1;
+        bool stopped = false;
+
+        cMessage *fork_run = nullptr;                   // fires once at forkAt when branches are configured
+        vector<long> fork_children;                     // process ids of the branches, waited for in finish()
 
         //simsignal_t errorSignal;
-        simsignal_t latencySignalXr;
-        simsignal_t latencySignalHmd;
-        simsignal_t latencySignalCtr;
-        simsignal_t latencySignalHpt;
-        simsignal_t latencySignalBkg;
+        simsignal_t latency_signals[CLASSES];           // <class>_latency, indexed like class_names
 
     public:
-        //virtual ~OLT();
+        virtual ~OLT();
 
     protected:
         double ber;
@@ -62,37 +117,74 @@ class OLT : public cSimpleModule
         // The following redefined virtual function holds the algorithm.
         virtual void initialize() override;
         virtual void handleMessage(cMessage *msg) override;
+        virtual void finish() override;
+        virtual void resumeCycles();
+        virtual void reassemble(ethPacket *pkt);
+        virtual void sweepReassembly();
+        virtual void recordHops(ethPacket *pkt);
+        virtual void parseScope();
+        virtual bool inScope(ethPacket *pkt);
+        virtual void parseStopMetric();
+        virtual void forkBranches();
+        virtual void resetStatistics();
+        virtual void handleParameterChange(const char *parname) override;
         //virtual ponPacket *generateGrantPacket();
 };
 
 Define_Module(OLT);
 
+OLT::~OLT()
+{
+    cancelAndDelete(schedule_dl_gtc);
+    cancelAndDelete(send_dl_payload);
+    cancelAndDelete(fork_run);
+    delete dba;
+    delete stopper;
+    eth_packet_pool.clear();
+}
+
 void OLT::initialize()
 {
     //errorSignal = registerSignal("pkt_error");  // registering the signal
-    latencySignalXr = registerSignal("xr_latency");
-    latencySignalHmd = registerSignal("hmd_latency");
-    latencySignalCtr = registerSignal("ctrl_latency");
-    latencySignalHpt = registerSignal("hptc_latency");
-    latencySignalBkg = registerSignal("bkg_latency");
+    for(int c = 0; c < CLASSES; c++) {
+        latency_signals[c] = registerSignal((string(class_names[c]) + "_latency").c_str());
+    }
 
     //olt_queue.setName("olt_queue");
 
     gate("SpltGate_i")->setDeliverImmediately(true);
 
+    schedule_dl_gtc = new cMessage("schedule_dl_gtc", SCHEDULE_DL_GTC);
+    send_dl_payload = new cMessage("send_dl_payload", SEND_DL_PAYLOAD);    // send downlink data
+    skip_idle_cycles = par("skipIdleCycles");
+    record_hop_latency = par("recordHopLatency");
+    reassembly_timeout = par("reassemblyTimeout").doubleValue();
+    next_reassembly_sweep = reassembly_timeout;
+    if(record_hop_latency)
+        hop_latency.assign(CLASSES, vector<LogHistogram>(HOPS));
+
+    eth_packet_pool.clear();                      // one packet pool per simulation run
+
     onus = par("NumberOfONUs");
     EV << getFullName() <<" No. of ONUs detected = " << onus << endl;
 
+    parseScope();
+    if(par("detectWarmup").boolValue())
+        warmup.assign(CLASSES, MserDetector(par("warmupCheckInterval").doubleValue(), par("warmupMinBatches").intValue()));
+    parseStopMetric();
+
+    if((par("forkAt").doubleValue() > 0) && (!par("forkDbaPolicies").stdstringValue().empty() || !par("forkLoads").stdstringValue().empty())) {
+        fork_run = new cMessage("fork_run", FORK_RUN);
+        scheduleAt(par("forkAt").doubleValue(), fork_run);
+    }
+    flow_latency.assign(onus*CLASSES, LogHistogram(1e-9, 8, 34));      // 0.8% resolution up to 17 s keeps the table small
+
     onu_rtt.resize(onus,0);
     onu_buffer_TC1.resize(onus,0);
     onu_buffer_TC2.resize(onus,0);
     onu_buffer_TC3.resize(onus,0);
     onu_grant_TC1.resize(onus,0);
-    onu_grant_TC2.resize(onus,0);
-    onu_grant_TC3.resize(onus,0);
     onu_start_time_TC1.resize(onus,0);
-    onu_start_time_TC2.resize(onus,0);
-    onu_start_time_TC3.resize(onus,0);
 
     for(int j = 0; j<onus; j++) {
         onu_index.push_back(j);
@@ -101,105 +193,75 @@ void OLT::initialize()
     //EV << getFullName() <<" onu_rtt[0] = " << onu_rtt[0] << ", onu_rtt[1] = " << onu_rtt[1] << endl;
     // bw_map = [onu_id, tc_type, start_time, grant_size]
 
-    ping *png = new ping("ping");      // sending ping message at T = 0 for finding the RTT of all ONUs
+    ping *png = new ping("ping", PING);      // sending ping message at T = 0 for finding the RTT of all ONUs
     send(png,"SpltGate_o");
     EV << getFullName() << " Sending ping from OLT at = " << simTime() << endl;
 }
 
 void OLT::handleMessage(cMessage *msg)
 {
-    if(msg->isPacket() == true) {
-        if(strcmp(msg->getName(),"gtc_hdr_ul") == 0) {                  // updating buffer size after receiving requests from ONUs
+    switch(msg->getKind()) {
+        case GTC_HDR_UL: {                  // updating buffer size after receiving requests from ONUs
             gtc_header *pkt = check_and_cast<gtc_header *>(msg);
 
             int onuId = pkt->getOnuID();
             // for T-CONT 2
             onu_buffer_TC2[onuId] = pkt->getBufferOccupancyTC2();
-            EV << getFullName() << " updated onu_buffer_TC2[" << onuId << "] = " << onu_buffer_TC2[onuId] << endl;
+            EV_DEBUG << getFullName() << " updated onu_buffer_TC2[" << onuId << "] = " << onu_buffer_TC2[onuId] << endl;
             // for T-CONT 3
             onu_buffer_TC3[onuId] = pkt->getBufferOccupancyTC3();
-            EV << getFullName() <<" updated onu_buffer_TC3[" << onuId << "] = " << onu_buffer_TC3[onuId] << endl;
-
-            delete pkt;         // nothing more to do with the header
-        }
-        else if(strcmp(msg->getName(),"bkg_data") == 0) {
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
+            EV_DEBUG << getFullName() <<" updated onu_buffer_TC3[" << onuId << "] = " << onu_buffer_TC3[onuId] << endl;
 
-            int onuId = pkt->getOnuId();
-            int sfuId = pkt->getSfuId();
-            int mfuId = pkt->getMfuId();
-            int tcId = pkt->getTContId();
-
-            if((onuId==0) && (mfuId==0)) {                          // Background from random devices at all SFUs
-                double bkg_packet_latency = pkt->getArrivalTime().dbl() - pkt->getGenerationTime().dbl();
-                EV << getFullName() << " background packet_latency: " << bkg_packet_latency << endl;
-                emit(latencySignalBkg, bkg_packet_latency);
+            if(suspended && ((onu_buffer_TC2[onuId] > 0) || (onu_buffer_TC3[onuId] > 0))) {
+                resumeCycles();             // new data reported, back to one map per cycle
             }
-            delete pkt;
-        }
-        else if(strcmp(msg->getName(),"xr_data") == 0) {
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
 
-            int onuId = pkt->getOnuId();
-            int sfuId = pkt->getSfuId();
-            int mfuId = pkt->getMfuId();
-            int tcId = pkt->getTContId();
-
-            if((onuId==0) && (mfuId==0) && ((sfuId%2)==0)) {            // XR from robots at odd SFUs
-                double xr_packet_latency = pkt->getArrivalTime().dbl() - pkt->getGenerationTime().dbl();
-                EV << getFullName() << " XR packet_latency: " << xr_packet_latency << endl;
-                emit(latencySignalXr, xr_packet_latency);
-            }
-            delete pkt;
+            delete pkt;         // nothing more to do with the header
+            break;
         }
-        else if(strcmp(msg->getName(),"haptic_data") == 0) {
+        case BKG_DATA:
+        case XR_DATA:
+        case HMD_DATA:
+        case CONTROL_DATA:
+        case HAPTIC_DATA: {                 // data of all traffic classes, measured when inside the measurement scope
             ethPacket *pkt = check_and_cast<ethPacket *>(msg);
 
             int onuId = pkt->getOnuId();
-            int sfuId = pkt->getSfuId();
-            int mfuId = pkt->getMfuId();
-            int tcId = pkt->getTContId();
-
-            if((onuId==0) && (mfuId==0) && ((sfuId%2)==0)) {            // Haptics from robots at odd SFUs
-                double hptc_packet_latency = pkt->getArrivalTime().dbl() - pkt->getGenerationTime().dbl();
-                EV << getFullName() << " Haptic packet_latency: " << hptc_packet_latency << endl;
-                emit(latencySignalHpt, hptc_packet_latency);
+            int cls = pkt->getKind() - BKG_DATA;
+            reassemble(pkt);                    // last piece of a fragmented packet completes it
+
+            double packet_latency = pkt->getArrivalTime().dbl() - pkt->getGenerationTime().dbl();
+            if(inScope(pkt) && (warmup.empty() || warmup[cls].collect(simTime(), packet_latency))) {    // start-up samples are discarded
+                EV_TRACE << getFullName() << " " << class_names[cls] << " packet_latency: " << packet_latency << " from ONU-" << onuId << ", SFU-" << pkt->getSfuId() << endl;
+                emit(latency_signals[cls], packet_latency);
+                flow_latency[onuId*CLASSES + cls].collect(packet_latency);
+                recordHops(pkt);
+                if((cls == stop_class) && stopper->collect(packet_latency))
+                    stopped = true;
             }
-            delete pkt;
-        }
-        else if(strcmp(msg->getName(),"hmd_data") == 0) {
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            int onuId = pkt->getOnuId();
-            int sfuId = pkt->getSfuId();
-            int mfuId = pkt->getMfuId();
-            int tcId = pkt->getTContId();
-
-            if((onuId==0) && (mfuId==0) && ((sfuId%2)!=0)) {            // HMD from humans at odd SFUs
-                double hmd_packet_latency = pkt->getArrivalTime().dbl() - pkt->getGenerationTime().dbl();
-                EV << getFullName() << " HMD packet_latency: " << hmd_packet_latency << endl;
-                emit(latencySignalHmd, hmd_packet_latency);
+            drop(pkt);
+            eth_packet_pool.release(pkt);       // hand the packet back to the sources
+            if(stopped) {
+                EV << getFullName() << " " << par("stopMetric").stringValue() << " = " << stopper->getEstimate() << " +/- " << stopper->getHalfWidth() << ", stopping at " << simTime() << endl;
+                endSimulation();
             }
-            delete pkt;
+            break;
         }
-        else if(strcmp(msg->getName(),"control_data") == 0) {
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            int onuId = pkt->getOnuId();
-            int sfuId = pkt->getSfuId();
-            int mfuId = pkt->getMfuId();
-            int tcId = pkt->getTContId();
-
-            if((onuId==0) && (mfuId==0) && ((sfuId%2)!=0)) {            // Control from humans at odd SFUs
-                double ctrl_packet_latency = pkt->getArrivalTime().dbl() - pkt->getGenerationTime().dbl();
-                EV << getFullName() << " Control packet_latency: " << ctrl_packet_latency << endl;
-                emit(latencySignalCtr, ctrl_packet_latency);
-            }
-            delete pkt;
+        case ETH_FRAGMENT: {
+            ethFragment *frag = check_and_cast<ethFragment *>(msg);
+            Reassembly& entry = reassembly[frag->getPacketId()];
+            if(entry.bytes == 0)
+                entry.first_fragment = simTime();
+            entry.bytes += frag->getByteLength();         // the packet itself brings the rest
+            if(frag->getIndex() < 64)
+                entry.indices |= (uint64_t)1 << frag->getIndex();
+            fragments_received++;
+            delete frag;
+            if(simTime() >= next_reassembly_sweep)
+                sweepReassembly();
+            break;
         }
-    }
-    else {
-        if(strcmp(msg->getName(),"ping") == 0) {
+        case PING: {
             ping_count += 1;
             ping *png = check_and_cast<ping *>(msg);
             int onu_id = png->getONU_id();
@@ -211,22 +273,25 @@ void OLT::handleMessage(cMessage *msg)
 
             if(ping_count == onus) {
                 //EV << getFullName() << " onu_total_latency[0] = " << onu_total_latency[0] << ", onu_total_latency[1] = " << onu_total_latency[1] << endl;
-                cMessage *schedule_dl_gtc = new cMessage("schedule_dl_gtc");
                 scheduleAt(simTime(), schedule_dl_gtc);           // when ping from all ONUs arrive, initiate the grant scheduling process
 
                 onu_max_grant = floor((max_polling_cycle - T_guard*onus)*(ext_pon_link_datarate/onus)/8);  // in Bytes
                 //EV << getFullName() <<" worst_rtt = " << worst_rtt << ", onu_max_grant = " << onu_max_grant << endl;
                 for(int i = 0;i<onus;i++) {
-                    onu_grant_TC3[i] = onu_max_grant;       // initializing all ONUs with maximum grant value
-                    onu_buffer_TC3[i] = onu_max_grant;
+                    onu_buffer_TC3[i] = onu_max_grant;       // initializing all ONUs with maximum grant value
                 }
+
+                delete dba;
+                dba = DBA::create(par("dbaPolicy"), onus, onu_max_grant, ext_pon_link_datarate);
+                EV << getFullName() << " DBA policy = " << dba->getPolicyName() << endl;
             }
             delete png;
+            break;
         }
-        else if(strcmp(msg->getName(),"schedule_dl_gtc") == 0) {        // calculating the time-instants for sending grants to onus
+        case SCHEDULE_DL_GTC: {        // calculating the time-instants for sending grants to onus
             scheduleAt(simTime()+(simtime_t)125e-6, msg);                          // schedule the self-message after 125 usec
 
-            gtc_header *gtc_hdr_dl = new gtc_header("gtc_hdr_dl");
+            gtc_dl_header *gtc_hdr_dl = new gtc_dl_header("gtc_hdr_dl", GTC_HDR_DL);
             double us_bw_map_sz = onus*8;                                  // (N x 8) Bytes
             double gtc_hdr_sz = 4 + 4 + 13 + 1 + (4*2) + us_bw_map_sz;     // total size of GTC DL header
             //EV << getFullName() << " total GTC DL Header size = " << gtc_hdr_sz << endl;
@@ -234,53 +299,388 @@ void OLT::handleMessage(cMessage *msg)
             gtc_hdr_dl->setDownlink(true);
             gtc_hdr_dl->setExt_pon(true);
             gtc_hdr_dl->setSeqID(++seqID);
-            gtc_hdr_dl->setOlt_onu_rttArraySize(onus);
-            for (int i = 0; i < onus; ++i) {
-                gtc_hdr_dl->setOlt_onu_rtt(i, onu_rtt[i]);
-            }
-
-            gtc_hdr_dl->setOnu_start_time_TC2ArraySize(onus);
-            gtc_hdr_dl->setOnu_grant_TC2ArraySize(onus);
-            gtc_hdr_dl->setOnu_start_time_TC3ArraySize(onus);
-            gtc_hdr_dl->setOnu_grant_TC3ArraySize(onus);
 
             double worst_rtt = *std::max_element(onu_rtt.begin(), onu_rtt.end());
-            double tx_start = 0;
+            BandwidthMap *bw_map = dba->schedule(onu_rtt, onu_buffer_TC2, onu_buffer_TC3);      // grants of this cycle from the selected policy
 
             for(int i = 0;i<onus;i++) {
-                double onu_max_grant_TC2 = (onu_buffer_TC2[i]/(onu_buffer_TC2[i]+onu_buffer_TC3[i]))*onu_max_grant;
-                double onu_max_grant_TC3 = (1-(onu_buffer_TC2[i]/(onu_buffer_TC2[i]+onu_buffer_TC3[i])))*onu_max_grant;
-
-                onu_grant_TC2[i] = std::min(onu_buffer_TC2[i],onu_max_grant_TC2);      // granting BW using limited service policy
-                onu_grant_TC3[i] = std::min(onu_buffer_TC3[i],onu_max_grant_TC3);
-                //onu_grant_TC2[i] = onu_max_grant/2;                             // granting BW using fixed service policy
-                //onu_grant_TC3[i] = onu_max_grant/2;
-
-                // filling into the header packet for T-CONT 2
-                onu_start_time_TC2[i] = tx_start + T_guard;
-                gtc_hdr_dl->setOnu_start_time_TC2(i, onu_start_time_TC2[i]);
-                gtc_hdr_dl->setOnu_grant_TC2(i, onu_grant_TC2[i]);
-                // filling into the header packet for T-CONT 3
-                onu_start_time_TC3[i] = tx_start + T_guard + (onu_grant_TC2[i]*8/ext_pon_link_datarate);
-                gtc_hdr_dl->setOnu_start_time_TC3(i, onu_start_time_TC3[i]);
-                gtc_hdr_dl->setOnu_grant_TC3(i, onu_grant_TC3[i]);
-                // shifting the tx_start cursor
-                tx_start += T_guard + (onu_grant_TC2[i]*8/ext_pon_link_datarate) + (onu_grant_TC3[i]*8/ext_pon_link_datarate);
-
-                EV << getFullName() << " onu_start_time_TC2[" << i << "] = " << simTime().dbl()+2*125e-6+onu_start_time_TC2[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
-                EV << getFullName() << " onu_start_time_TC3[" << i << "] = " << simTime().dbl()+2*125e-6+onu_start_time_TC3[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
+                EV_DEBUG << getFullName() << " onu_start_time_TC2[" << i << "] = " << simTime().dbl()+bw_map->tx_offset+bw_map->start_time_TC2[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
+                EV_DEBUG << getFullName() << " onu_start_time_TC3[" << i << "] = " << simTime().dbl()+bw_map->tx_offset+bw_map->start_time_TC3[i]-(worst_rtt/2) << " for seqID = " << seqID << endl;
+            }
+            EV_DEBUG << getFullName() << " last ONU tx finish time = " << simTime().dbl()+bw_map->tx_offset+bw_map->start_time_TC3[onus-1]-(worst_rtt/2)+(bw_map->grant_TC3[onus-1]*8/ext_pon_link_datarate) << " for seqID = " << seqID << endl;
+
+            if(skip_idle_cycles && dba->isIdle(onu_buffer_TC2, onu_buffer_TC3, bw_map)) {
+                bw_map->standing = true;        // the ONUs keep using this map until the next one
+                cancelEvent(msg);
+                suspended = true;
+                suspend_time = simTime();
+                EV << getFullName() << " all ONUs idle, cycle timer stopped after seqID = " << seqID << endl;
             }
-            EV << getFullName() << " last ONU tx finish time = " << simTime().dbl()+2*125e-6+onu_start_time_TC3[onus-1]-(worst_rtt/2)+(onu_grant_TC3[onus-1]*8/ext_pon_link_datarate) << " for seqID = " << seqID << endl;
+
+            // the bandwidth map is shared by all copies of the header
+            gtc_hdr_dl->setBwMap(std::shared_ptr<const BandwidthMap>(bw_map));
 
             send(gtc_hdr_dl,"SpltGate_o");          // sending the downlink GTC header to ONUs
 
-            cMessage *send_dl_payload = new cMessage("send_dl_payload");    // send downlink data
             scheduleAt(simTime(), send_dl_payload);
+            timer_allocs_avoided++;
+            break;
+        }
+        case FORK_RUN: {
+            forkBranches();
+            break;
+        }
+        case SEND_DL_PAYLOAD: {        // sending the downlink GTC header to ONUs
+            // not doing anything now, just keeping the provision for future
+            break;
+        }
+        default:
+            EV << getFullName() << " Some unknown cMessage has arrived at = " << simTime() << endl;
+            delete msg;
+            break;
+    }
+}
+
+void OLT::finish()
+{
+#ifndef _WIN32
+    for(long pid : fork_children) {
+        waitpid((pid_t)pid, nullptr, 0);                // the parent run ends after all of its branches
+    }
+#endif
+    recordScalar("fork branches", fork_children.size());
+
+    // every re-arm of send_dl_payload used to be a fresh cMessage allocation
+    recordScalar("timer allocations avoided", timer_allocs_avoided);
+    if(simTime() > 0)
+        recordScalar("timer allocations avoided per second", timer_allocs_avoided/simTime().dbl());
+
+    recordScalar("idle cycles skipped", idle_cycles_skipped);
+    recordScalar("fragments received", fragments_received);
+    recordScalar("packets reassembled", packets_reassembled);
+    recordScalar("reassembly errors", reassembly_errors);
+    recordScalar("reassembly timeouts", reassembly_timeouts);
+    recordScalar("reassembly mismatches", reassembly_mismatches);
+    for(size_t c = 0; c < warmup.size(); c++) {
+        string name = class_names[c];
+        recordScalar((name + " warmup detected").c_str(), warmup[c].isSteady());
+        recordScalar((name + " warmup samples discarded").c_str(), warmup[c].getDiscarded());
+        if(!warmup[c].isSteady() && (warmup[c].getDiscarded() > 0))      // typically an overloaded load point
+            EV_WARN << getFullName() << " " << name << " never reached steady state, all " << warmup[c].getDiscarded() << " latency samples were discarded and no " << name << " latency is recorded" << endl;
+        if(warmup[c].isSteady()) {
+            recordScalar((name + " warmup truncation point").c_str(), warmup[c].getTruncationTime());
+            recordScalar((name + " warmup end").c_str(), warmup[c].getSteadyTime());
+        }
+    }
+    if(stopper != nullptr) {
+        recordScalar("stopped by confidence interval", stopped);
+        recordScalar("stop metric batches", stopper->getBatches());
+        recordScalar("stop metric estimate", stopper->getEstimate());
+        recordScalar("stop metric half width", stopper->getHalfWidth());
+    }
+    for(int o = 0; o < onus; o++) {
+        for(int c = 0; c < CLASSES; c++) {
+            if(flow_latency[o*CLASSES + c].getCount() > 0)
+                flow_latency[o*CLASSES + c].recordScalars(this, "onu" + to_string(o) + "_" + class_names[c] + "_latency");
+        }
+    }
+    for(size_t c = 0; c < hop_latency.size(); c++) {
+        for(int h = 0; h < HOPS; h++) {
+            hop_latency[c][h].recordScalars(this, string(class_names[c]) + "_" + hop_names[h] + "_latency");
+        }
+    }
+    if(dba != nullptr) {
+        recordScalar("upstream grant utilization", dba->getUtilization());      // granted share of the upstream capacity
+        recordScalar("redistributed excess share", dba->getRedistributedShare());   // part of the grants taken from lightly loaded units
+    }
+
+    // ethPacket recycling between the sources and the OLT sink
+    recordScalar("packet pool hit rate", eth_packet_pool.getHitRate());
+    recordScalar("packet pool allocations", eth_packet_pool.getMisses());
+    recordScalar("packet pool peak live packets", eth_packet_pool.getPeakLive());
+}
+
+/*
+ * Restarts the cycle timer at the first cycle boundary not before now, so the
+ * phase is the same as if the timer had kept running. The skipped cycles would
+ * all have carried the standing map and are only counted.
+ */
+void OLT::resumeCycles()
+{
+    simtime_t next_cycle = suspend_time + (simtime_t)125e-6;
+    long skipped = 0;
+    while(next_cycle < simTime()) {
+        next_cycle += (simtime_t)125e-6;
+        skipped++;
+    }
+    seqID += skipped;
+    dba->skipCycles(skipped);
+    idle_cycles_skipped += skipped;
+    suspended = false;
+
+    scheduleAt(next_cycle, schedule_dl_gtc);
+    EV << getFullName() << " cycle timer resumed at " << next_cycle << " after " << skipped << " idle cycles" << endl;
+}
+
+/*
+ * The last piece of a fragmented packet is the packet itself, carrying the
+ * bytes not yet covered by fragment descriptors. It completes the reassembly.
+ * The entry must hold exactly the fragment indices 1..FragmentCount of the
+ * packet; anything else means fragments of two packets met in one entry.
+ */
+void OLT::reassemble(ethPacket *pkt)
+{
+    if(pkt->getFragmentCount() == 0)
+        return;
+    auto it = reassembly.find(pkt->getSequenceNumber());
+    if(it == reassembly.end()) {
+        reassembly_errors++;
+        return;
+    }
+    int count = pkt->getFragmentCount();
+    if((count < 63) && (it->second.indices != ((((uint64_t)1 << count) - 1) << 1))) {
+        reassembly_mismatches++;
+        EV_WARN << getFullName() << " packet " << pkt->getSequenceNumber() << " has " << count << " fragments, but other fragment indices arrived" << endl;
+    }
+    EV_TRACE << getFullName() << " reassembled packet " << pkt->getSequenceNumber() << " from " << pkt->getFragmentCount() << " fragments, " << it->second.bytes + pkt->getByteLength() << " bytes" << endl;
+    reassembly.erase(it);
+    packets_reassembled++;
+}
 
+/*
+ * A packet whose fragments already arrived can still be dropped by a full ONU
+ * buffer. Its entry would never complete, so entries older than
+ * reassemblyTimeout are removed. Runs at most once per timeout.
+ */
+void OLT::sweepReassembly()
+{
+    for(auto it = reassembly.begin(); it != reassembly.end(); ) {
+        if(simTime() - it->second.first_fragment > reassembly_timeout) {
+            it = reassembly.erase(it);
+            reassembly_timeouts++;
         }
-        else if(strcmp(msg->getName(),"send_dl_payload") == 0) {        // sending the downlink GTC header to ONUs
-            delete msg;         // not doing anything now, just keeping the provision for future
+        else
+            ++it;
+    }
+    next_reassembly_sweep = simTime() + reassembly_timeout;
+}
+
+/*
+ * Splits the latency of a measured packet at the timestamps set along the way.
+ * The 10G-PON segment runs from the SFU to the ONU and includes the MFU, the
+ * 50G-PON segment from the ONU to the OLT. The segments add up to the latency.
+ */
+void OLT::recordHops(ethPacket *pkt)
+{
+    if(!record_hop_latency)
+        return;
+    vector<LogHistogram>& hops = hop_latency[pkt->getKind() - BKG_DATA];
+    hops[WIRELESS].collect((pkt->getWapArrivalTime() - pkt->getGenerationTime()).dbl());
+    hops[WAP].collect((pkt->getWapDepartureTime() - pkt->getWapArrivalTime()).dbl());
+    hops[SFU_QUEUE].collect((pkt->getSfuDepartureTime() - pkt->getSfuArrivalTime()).dbl());
+    hops[PON10G_UP].collect((pkt->getOnuArrivalTime() - pkt->getSfuDepartureTime()).dbl());
+    hops[ONU_QUEUE].collect((pkt->getOnuDepartureTime() - pkt->getOnuArrivalTime()).dbl());
+    hops[PON50G_UP].collect((pkt->getArrivalTime() - pkt->getOnuDepartureTime()).dbl());
+}
+
+/*
+ * measureScope "all" measures every packet, "onus" and "sfus" only packets of
+ * the ONUs in measureOnus or the SFUs in measureSfus. SFU indices are global,
+ * as in the sfus[] array. measureFraction then samples the packets in scope.
+ */
+void OLT::parseScope()
+{
+    string scope = par("measureScope").stdstringValue();
+    measure_fraction = par("measureFraction");
+    if((measure_fraction <= 0) || (measure_fraction > 1))
+        throw cRuntimeError("measureFraction must be in (0,1], got %g", measure_fraction);
+
+    if(scope == "all")
+        return;
+    bool by_onu = (scope == "onus");
+    if(!by_onu && (scope != "sfus"))
+        throw cRuntimeError("Unknown measureScope \"%s\", use \"all\", \"onus\" or \"sfus\"", scope.c_str());
+
+    int units = by_onu ? onus : onus*(int)getParentModule()->par("NumberOfSFUs");
+    vector<bool>& mask = by_onu ? onu_scope : sfu_scope;
+    mask.assign(units, false);
+    for(int id : cStringTokenizer(par(by_onu ? "measureOnus" : "measureSfus").stringValue()).asIntVector()) {
+        if((id < 0) || (id >= units))
+            throw cRuntimeError("measureScope \"%s\": index %d out of range 0..%d", scope.c_str(), id, units-1);
+        mask[id] = true;
+    }
+    EV << getFullName() << " measuring " << std::count(mask.begin(), mask.end(), true) << " of " << units << " " << scope << endl;
+}
+
+bool OLT::inScope(ethPacket *pkt)
+{
+    if(!onu_scope.empty() && !onu_scope[pkt->getOnuId()])
+        return false;
+    if(!sfu_scope.empty() && !sfu_scope[pkt->getSfuId()])
+        return false;
+    if(measure_fraction >= 1)
+        return true;
+    // golden ratio sequence, spreads the samples evenly without taking numbers from the shared RNG
+    sample_phase += 0.6180339887498949;
+    if(sample_phase >= 1)
+        sample_phase -= 1;
+    return sample_phase < measure_fraction;
+}
+
+/*
+ * stopMetric is "<class>_mean" or "<class>_p<percent>", e.g. "xr_p99" or
+ * "bkg_mean" (background is the T-CONT 3 traffic). Empty runs to sim-time-limit.
+ */
+void OLT::parseStopMetric()
+{
+    string metric = par("stopMetric").stdstringValue();
+    if(metric.empty())
+        return;
+
+    size_t split = metric.rfind('_');
+    string cls = metric.substr(0, split);
+    string stat = (split == string::npos) ? "" : metric.substr(split + 1);
+    for(int c = 0; c < CLASSES; c++) {
+        if(cls == class_names[c])
+            stop_class = c;
+    }
+    double quantile = -1;
+    if(stat == "mean")
+        quantile = 0;
+    else if((stat.size() > 1) && (stat[0] == 'p')) {
+        char *end;
+        double percent = strtod(stat.c_str() + 1, &end);
+        if((*end == '\0') && (percent > 0) && (percent < 100))       // "p0", "p" or "pfoo" would silently be the mean
+            quantile = percent/100;
+    }
+    if((stop_class < 0) || (quantile < 0))
+        throw cRuntimeError("Unknown stopMetric \"%s\", use <class>_mean or <class>_p<percent> with class bkg, xr, hmd, ctrl or hptc and 0 < percent < 100", metric.c_str());
+
+    stopper = new BatchMeansStopper(quantile, par("stopBatchSize").intValue(), par("stopMinBatches").intValue(), par("stopRelativeWidth").doubleValue());
+}
+
+/*
+ * dbaPolicy may change while the simulation runs, e.g. in a branch forked by
+ * the OLT. The new policy starts with fresh utilization counters.
+ */
+void OLT::handleParameterChange(const char *parname)
+{
+    if((strcmp(parname, "dbaPolicy") == 0) && (dba != nullptr)) {
+        delete dba;
+        dba = DBA::create(par("dbaPolicy"), onus, onu_max_grant, ext_pon_link_datarate);
+        EV << getFullName() << " DBA policy changed to " << dba->getPolicyName() << " at " << simTime() << endl;
+    }
+}
+
+/*
+ * Forks the warmed-up network into one child process per combination of
+ * forkDbaPolicies and forkLoads. Each child keeps every queue, DBA vector and
+ * RNG state of the parent, so all branches see the same random numbers. It
+ * changes dbaPolicy of the OLT and MFUs and/or load of the background devices,
+ * then continues in the directory fork-<policy>-load<load>. Result files are
+ * opened at the first write, so with relative paths (the default) each branch
+ * writes its own, but only if no result file or eventlog is open at forkAt: a
+ * child would inherit the handle and write into the parent's file. Forking is
+ * therefore refused when vectors or scalars were already written, or the
+ * eventlog is recorded. The statistics of the common part before forkAt are
+ * reset in the parent and in all branches, so every result starts at forkAt.
+ */
+void OLT::forkBranches()
+{
+#ifdef _WIN32
+    throw cRuntimeError("forkAt needs fork(), which is not available on Windows");
+#else
+    for(cModule::SubmoduleIterator it(getParentModule()); !it.end(); ++it) {
+        if((*it)->isPlaceholder())
+            throw cRuntimeError("forkAt cannot be combined with parallel simulation");
+    }
+    cConfiguration *config = getEnvir()->getConfig();
+    if(config->getAsBool("record-eventlog"))
+        throw cRuntimeError("forkAt cannot be combined with record-eventlog, the branches would write into one eventlog");
+    for(const char *key : {"output-vector-file", "output-scalar-file"}) {
+        struct stat st;
+        string file = config->getAsFilename(key);
+        if(stat(file.c_str(), &st) == 0)
+            throw cRuntimeError("forkAt: %s is already open, the branches would write into it; record no results before forkAt (e.g. no vectors)", file.c_str());
+    }
+
+    resetStatistics();              // before fork(), so the parent and every branch start clean
+
+    vector<string> policies = cStringTokenizer(par("forkDbaPolicies").stringValue()).asVector();
+    vector<string> loads = cStringTokenizer(par("forkLoads").stringValue()).asVector();
+    if(policies.empty())
+        policies.push_back("");                 // keep the policy, vary only the load
+    if(loads.empty())
+        loads.push_back("");
+
+    for(const string& policy : policies) {
+        for(const string& load : loads) {
+            string branch = "fork";
+            if(!policy.empty())
+                branch += "-" + policy;
+            if(!load.empty())
+                branch += "-load" + load;
+
+            fflush(stdout);                     // buffered output would be printed by every branch
+            std::cout.flush();
+            pid_t pid = fork();
+            if(pid < 0)
+                throw cRuntimeError("fork() for branch %s failed: %s", branch.c_str(), strerror(errno));
+            if(pid > 0) {
+                fork_children.push_back(pid);
+                EV << getFullName() << " forked branch " << branch << " as process " << pid << " at " << simTime() << endl;
+                continue;
+            }
+
+            // child: switch to the branch directory and parameters, then carry on with the run
+            fork_children.clear();
+            mkdir(branch.c_str(), 0777);
+            if(chdir(branch.c_str()) != 0)
+                throw cRuntimeError("Cannot enter branch directory %s: %s", branch.c_str(), strerror(errno));
+            for(cModule::SubmoduleIterator it(getParentModule()); !it.end(); ++it) {
+                cModule *module = *it;
+                if(!policy.empty() && module->hasPar("dbaPolicy"))
+                    module->par("dbaPolicy").setStringValue(policy.c_str());
+                if(!load.empty() && module->hasPar("load"))
+                    module->par("load").setDoubleValue(atof(load.c_str()));
+            }
+            return;
         }
     }
+#endif
 }
 
+/*
+ * Forgets everything measured so far: the latency tables, the stopping rule
+ * batches, the reassembly and DBA counters of the OLT, and via the statsReset
+ * signal the counters of the ONUs, SFUs and MFUs. The latency signal
+ * recorders are not reachable from here, warmup-period covers them.
+ */
+void OLT::resetStatistics()
+{
+    for(LogHistogram& histogram : flow_latency) {
+        histogram.clear();
+    }
+    for(vector<LogHistogram>& hops : hop_latency) {
+        for(LogHistogram& histogram : hops) {
+            histogram.clear();
+        }
+    }
+    if(stopper != nullptr)
+        stopper->reset();
+    if(dba != nullptr)
+        dba->resetCounters();
+    fragments_received = 0;
+    packets_reassembled = 0;
+    reassembly_errors = 0;
+    reassembly_timeouts = 0;
+    reassembly_mismatches = 0;
+    idle_cycles_skipped = 0;
+
+    simsignal_t stats_reset = registerSignal("statsReset");
+    for(cModule::SubmoduleIterator it(getParentModule()); !it.end(); ++it) {
+        if((*it)->getProperties()->get("signal", "statsReset") != nullptr)     // ONUs, SFUs and MFUs
+            (*it)->emit(stats_reset, true);
+    }
+    EV << getFullName() << " statistics reset at " << simTime() << endl;
+}
@@ -0,0 +1,53 @@
+/*
+ * output_port.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include "output_port.h"
+
+OutputPort::~OutputPort()
+{
+    if(module != nullptr)
+        module->cancelAndDelete(tx_finished);
+}
+
+void OutputPort::init(cSimpleModule *module, cGate *gate, const char *timerName, short timerKind)
+{
+    this->module = module;
+    out_gate = gate;
+    channel = gate->getTransmissionChannel();
+    queue.setName(gate->getFullName());
+
+    tx_finished = new cMessage(timerName, timerKind);
+    tx_finished->setContextPointer(this);
+}
+
+void OutputPort::send(cPacket *pkt)
+{
+    if((channel == nullptr) || ((channel->isBusy() == false) && queue.isEmpty())) {
+        module->send(pkt, out_gate);
+        return;
+    }
+
+    queue.insert(pkt);
+    queued_bytes += pkt->getByteLength();
+    if(!tx_finished->isScheduled()) {
+        module->scheduleAt(channel->getTransmissionFinishTime(), tx_finished);
+    }
+}
+
+void OutputPort::handleTxFinished()
+{
+    if(queue.isEmpty())
+        return;
+
+    cPacket *pkt = (cPacket *)queue.pop();
+    queued_bytes -= pkt->getByteLength();
+    module->send(pkt, out_gate);
+
+    if(!queue.isEmpty()) {                      // wait for the packet just sent
+        module->scheduleAt(channel->getTransmissionFinishTime(), tx_finished);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * output_port.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef OUTPUT_PORT_H_
+#define OUTPUT_PORT_H_
+
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/*
+ * FIFO output port of a module gate connected through a datarate channel.
+ * A packet is sent immediately when the channel is idle and nothing is queued,
+ * otherwise it waits in the FIFO. A single self-message marks the end of the
+ * current transmission, so each port keeps at most one pending event no matter
+ * how long its queue grows. The self-message carries the port as its context
+ * pointer; the owning module passes it back through handleTxFinished().
+ */
+class OutputPort
+{
+    private:
+        cSimpleModule *module = nullptr;        // module owning the gate
+        cGate *out_gate = nullptr;
+        cChannel *channel = nullptr;            // transmission channel, nullptr if none
+        cQueue queue;                           // packets waiting for the channel
+        cMessage *tx_finished = nullptr;        // end of the ongoing transmission
+        long queued_bytes = 0;
+
+    public:
+        ~OutputPort();
+
+        void init(cSimpleModule *module, cGate *gate, const char *timerName, short timerKind);    // call from initialize()
+        void send(cPacket *pkt);                // send now or queue behind the ongoing transmission
+        void handleTxFinished();                // send the next queued packet
+
+        int getQueueLength() const { return queue.getLength(); }
+        long getQueuedBytes() const { return queued_bytes; }
+};
+
+#endif /* OUTPUT_PORT_H_ */
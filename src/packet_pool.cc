@@ -0,0 +1,83 @@
+/*
+ * packet_pool.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include <algorithm>
+
+#include "packet_pool.h"
+
+EthPacketPool eth_packet_pool;
+
+EthPacketPool::~EthPacketPool()
+{
+    clear();
+}
+
+ethPacket *EthPacketPool::acquire(const char *name, short kind)
+{
+    ethPacket *pkt;
+    if(!free_list.empty()) {
+        pkt = free_list.back();
+        free_list.pop_back();
+        hits++;
+
+        // bring the packet back to the state of a freshly constructed one
+        pkt->setName(name);
+        pkt->setKind(kind);
+        pkt->setByteLength(0);
+        pkt->setBitError(false);
+        pkt->setTimestamp(SIMTIME_ZERO);
+        pkt->setGenerationTime(SIMTIME_ZERO);
+        pkt->setWapArrivalTime(SIMTIME_ZERO);
+        pkt->setWapDepartureTime(SIMTIME_ZERO);
+        pkt->setSfuArrivalTime(SIMTIME_ZERO);
+        pkt->setSfuDepartureTime(SIMTIME_ZERO);
+        pkt->setOnuArrivalTime(SIMTIME_ZERO);
+        pkt->setOnuDepartureTime(SIMTIME_ZERO);
+        pkt->setOnuId(0);
+        pkt->setSfuId(0);
+        pkt->setMfuId(0);
+        pkt->setTContId(0);
+        pkt->setFragmentCount(0);
+    }
+    else {
+        pkt = new ethPacket(name, kind);        // owned by the calling module
+        misses++;
+    }
+
+    next_sequence++;                            // interleaved over the partitions, each has its own pool
+    long partitions = std::max(1, getEnvir()->getParsimNumPartitions());      // 0 without parsim
+    pkt->setSequenceNumber(next_sequence*partitions + getEnvir()->getParsimProcId());
+    ASSERT(pkt->getSequenceNumber() > 0);       // a constant number would merge the reassembly of all packets
+
+    live++;
+    if(live > peak_live)
+        peak_live = live;
+    return pkt;
+}
+
+void EthPacketPool::release(ethPacket *pkt)
+{
+    if((hits+misses == 0) || (free_list.size() >= max_free))
+        delete pkt;                             // nobody in this process would take it again
+    else
+        free_list.push_back(pkt);
+    if(live > 0)                                // never below zero, clear() may have run in between
+        live--;
+}
+
+void EthPacketPool::clear()
+{
+    for(ethPacket *pkt : free_list) {
+        delete pkt;
+    }
+    free_list.clear();
+    hits = 0;
+    misses = 0;
+    live = 0;
+    peak_live = 0;
+    next_sequence = 0;
+}
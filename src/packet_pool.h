@@ -0,0 +1,53 @@
+/*
+ * packet_pool.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef PACKET_POOL_H_
+#define PACKET_POOL_H_
+
+#include <vector>
+#include <omnetpp.h>
+
+#include "ethPacket_m.h"
+
+using namespace omnetpp;
+
+/*
+ * Recycles ethPacket objects between the traffic sources and the OLT sink.
+ * The OLT drop()s a received packet and hands it back with release(); a source
+ * gets it again from acquire() with all fields reset, and take()s it if it is
+ * not already the owner. Packets are still new'ed whenever the free list is empty.
+ * Every acquire() stamps a new sequence number, unique across parsim partitions.
+ * With parsim the OLT partition only releases, so a pool that never served an
+ * acquire() deletes released packets, and the free list is capped in any case.
+ */
+class EthPacketPool
+{
+    private:
+        static const size_t max_free = 65536;  // released packets beyond this are deleted
+        std::vector<ethPacket *> free_list;     // released packets waiting to be reused
+        long hits = 0;                          // acquire() served from the free list
+        long misses = 0;                        // acquire() that had to allocate
+        long live = 0;                          // packets handed out and not yet released
+        long peak_live = 0;
+        long next_sequence = 0;
+
+    public:
+        ~EthPacketPool();
+
+        ethPacket *acquire(const char *name, short kind);
+        void release(ethPacket *pkt);           // pkt must not be owned by any module
+        void clear();                           // deletes free packets and resets the counters
+
+        long getHits() const { return hits; }
+        long getMisses() const { return misses; }
+        long getPeakLive() const { return peak_live; }
+        double getHitRate() const { return (hits+misses > 0) ? (double)hits/(hits+misses) : 0.0; }
+};
+
+extern EthPacketPool eth_packet_pool;         // shared by all sources and the OLT of the running simulation
+
+#endif /* PACKET_POOL_H_ */
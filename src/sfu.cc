@@ -10,27 +10,34 @@
 #include <omnetpp.h>
 #include <numeric>   // Required for std::iota
 #include <algorithm> // Required for std::sort
+#include <deque>
+#include <climits>
 
 #include "sim_params.h"
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
+#include "bw_map.h"
+#include "fragment.h"
+#include "tcont_queue.h"
+#include "packet_pool.h"
 
 using namespace std;
 using namespace omnetpp;
 
-class SFU : public cSimpleModule
+class SFU : public cSimpleModule, public cListener
 {
     private:
-        cQueue queue_TC1;                       // queue for T-CONT 1 traffic: fixed bandwidth with guarantee
-        cQueue queue_TC2;                       // queue for T-CONT 2 traffic: assured bandwidth with bound
-        cQueue queue_TC3;                       // queue for T-CONT 3 traffic: assured bandwidth without guarantee
+        TContQueue queue_TC1;                   // queue for T-CONT 1 traffic: fixed bandwidth with guarantee
+        TContQueue queue_TC2;                   // queue for T-CONT 2 traffic: assured bandwidth with bound
+        TContQueue queue_TC3;                   // queue for T-CONT 3 traffic: assured bandwidth without guarantee
         cQueue gtc_dl_queue;                    // queue to store gtc_dl_headers
-        double capacity;                        // buffer size = 100 MB
-        double pending_buffer_TC1 = 0.0;          // pending data size in buffer
-        double pending_buffer_TC2 = 0.0;
-        double pending_buffer_TC3 = 0.0;
-        double packet_drop_count = 0.0;
+        double capacity;                        // buffer shared by all T-CONTs (bytes)
+        bool head_drop;                         // drop the oldest packets of the T-CONT instead of the arriving one
+        long packet_drop_count = 0;
+        long dropped_bytes = 0;
         double mfu_sfu_rtt = 0.0;
         double start_time_TC1 = 0.0;
         double sfu_grant_TC1 = 0.0;
@@ -41,6 +48,33 @@ class SFU : public cSimpleModule
         double gtc_hdr_sz = 0.0;
         long seqID;
 
+        cMessage *send_ul_header = nullptr;             // self-messages owned by the SFU, re-armed every cycle
+        cMessage *send_ul_payload_TC2 = nullptr;
+        cMessage *send_ul_payload_TC3 = nullptr;
+        deque<simtime_t> ul_header_times;               // pending send_ul_header instants while the timer is armed
+        long timer_allocs_avoided = 0;                  // self-message allocations saved by re-arming the timers
+
+        simtime_t burst_cursor;                         // end of the last packet handed to the channel in this burst
+        simtime_t burst_last_start;                     // departure of that packet
+        bool tc3_burst_open = false;                    // T-CONT 3 burst may still take newly arrived packets
+
+        cMessage *send_ul_standing = nullptr;           // reports for the cycles skipped by an idle scheduler
+        gtc_dl_header *standing_hdr = nullptr;          // last standing map received
+        long standing_seq = 0;                          // cycle of the next standing report
+        long standing_end = LONG_MAX;                   // first cycle with a map of its own
+
+        bool zero_grant_fast_path;                      // no payload-stage events in cycles without grant
+        long zero_grant_cycles = 0;
+        simsignal_t stats_reset = SIMSIGNAL_NULL;       // emitted on this module by the OLT when it forks branches
+
+        double max_queue_growth;                        // backlog growth that marks the run as unstable (bytes/s), 0 = off
+        simtime_t instability_window;
+        int instability_windows;                        // consecutive windows above the limit before the run ends
+        int unstable_windows = 0;
+        simtime_t last_check;
+        double last_backlog = 0;                        // queued plus dropped bytes at last_check
+        simtime_t unstable_at = -1;
+
         //simsignal_t latencySignalXr;
         //simsignal_t latencySignalBkg;
 
@@ -51,6 +85,14 @@ class SFU : public cSimpleModule
         // The following redefined virtual function holds the algorithm.
         virtual void initialize() override;
         virtual void handleMessage(cMessage *msg) override;
+        virtual void finish() override;
+        virtual bool transmitBurst(TContQueue& queue, double& grant);
+        virtual void sendReport();
+        virtual void startStandingReports(gtc_dl_header *dl_hdr);
+        virtual bool admit(cPacket *pkt, TContQueue& queue);
+        virtual void discard(cPacket *pkt);
+        virtual void checkStability();
+        virtual void receiveSignal(cComponent *source, simsignal_t signal, bool b, cObject *details) override;
 };
 
 Define_Module(SFU);
@@ -60,18 +102,44 @@ void SFU::initialize()
     //latencySignalXr = registerSignal("xr_latency");                     // registering the signal
     //latencySignalBkg = registerSignal("bkg_latency");
 
-    queue_TC1.setName("queue_TC1");
-    queue_TC2.setName("queue_TC2");
-    queue_TC3.setName("queue_TC3");
     gtc_dl_queue.setName("gtc_dl_queue");
-    capacity = sfu_buffer_capacity;
+    capacity = par("bufferCapacity");
+    const char *drop_policy = par("dropPolicy");
+    if(strcmp(drop_policy, "tail") == 0)
+        head_drop = false;
+    else if(strcmp(drop_policy, "head") == 0)
+        head_drop = true;
+    else
+        throw cRuntimeError("Unknown drop policy '%s' (expected tail or head)", drop_policy);
+
+    max_queue_growth = par("maxQueueGrowth");
+    instability_window = par("instabilityWindow");
+    instability_windows = par("instabilityWindows");
 
     gate("inWap")->setDeliverImmediately(true);
     gate("SpltGate_in")->setDeliverImmediately(true);
+
+    send_ul_header = new cMessage("send_ul_header", SEND_UL_HEADER);                  // send uplink header
+    send_ul_payload_TC2 = new cMessage("send_ul_payload_TC2", SEND_UL_PAYLOAD_TC2);   // send uplink data
+    send_ul_payload_TC3 = new cMessage("send_ul_payload_TC3", SEND_UL_PAYLOAD_TC3);
+    send_ul_standing = new cMessage("send_ul_standing", SEND_UL_STANDING);
+
+    zero_grant_fast_path = par("zeroGrantFastPath");
+
+    stats_reset = registerSignal("statsReset");
+    subscribe(stats_reset, this);
 }
 
 SFU::~SFU()
 {
+    if((stats_reset != SIMSIGNAL_NULL) && isSubscribed(stats_reset, this))
+        unsubscribe(stats_reset, this);           // the cListener base goes before the module
+    cancelAndDelete(send_ul_header);
+    cancelAndDelete(send_ul_payload_TC2);
+    cancelAndDelete(send_ul_payload_TC3);
+    cancelAndDelete(send_ul_standing);
+    delete standing_hdr;
+
     // Clean up queues
     while (!queue_TC1.isEmpty()) {
         delete queue_TC1.pop();
@@ -89,344 +157,362 @@ SFU::~SFU()
 
 void SFU::handleMessage(cMessage *msg)
 {
-    if(msg->isPacket() == true) {
-        if(strcmp(msg->getName(),"bkg_data") == 0) {                    // background traffic is considered for T-CONT 3
+    switch(msg->getKind()) {
+        case BKG_DATA: {                    // background traffic is considered for T-CONT 3
             ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-            double buffer = pending_buffer_TC1 + pending_buffer_TC2 + pending_buffer_TC3 + pkt->getByteLength();      // future buffer size if current packet is queued
-            if(buffer <= sfu_buffer_capacity) {                         // queue the current packet if there is buffer capacity
+            if(admit(pkt, queue_TC3)) {                         // queue the current packet if there is buffer capacity
                 pkt->setSfuArrivalTime(pkt->getArrivalTime());
                 pkt->setSfuId(getIndex());
-                pkt->setTContId(3);                                     // for TC-3
+                pkt->setTContId(3);             // for TC-3
                 //EV << getFullName() << " Packet arrived from source and being queued at SFU" << endl;
                 queue_TC3.insert(pkt);
-                pending_buffer_TC3 += pkt->getByteLength();
+
+                // the per-packet timer would still have picked this packet up before the burst ended
+                if(tc3_burst_open && (simTime() < burst_last_start)) {
+                    tc3_burst_open = transmitBurst(queue_TC3, sfu_grant_TC3);
+                }
 
                 //EV << getFullName() << " Current TC3 queue length = " << queue_TC3.getLength() << " at SFU = " << getIndex() <<endl;
-                //EV << getFullName() << " Current buffer length = " << pending_buffer_TC3 << " at SFU = " << getIndex() <<endl;
+                //EV << getFullName() << " Current buffer length = " << queue_TC3.getBytes() << " at SFU = " << getIndex() <<endl;
             }
-            //delete pkt;
+            break;
         }
-        else if(strcmp(msg->getName(),"xr_data") == 0) {                    // background traffic is considered for T-CONT 3
+        case XR_DATA:
+        case HMD_DATA:
+        case CONTROL_DATA:
+        case HAPTIC_DATA: {                 // XR, HMD, control and haptic traffic is considered for T-CONT 2
             ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-            double buffer = pending_buffer_TC1 + pending_buffer_TC2 + pending_buffer_TC3 + pkt->getByteLength();      // future buffer size if current packet is queued
-            if(buffer <= sfu_buffer_capacity) {                             // queue the current packet if there is buffer capacity
+            if(admit(pkt, queue_TC2)) {                         // queue the current packet if there is buffer capacity
                 pkt->setSfuArrivalTime(pkt->getArrivalTime());
                 pkt->setSfuId(getIndex());
-                pkt->setTContId(2);                 // for TC-2
-                //pkt->setTContId(3);               // for TC-3
+                pkt->setTContId(2);             // for TC-2
+                //pkt->setTContId(3);             // for TC-3
                 //EV << getFullName() << " Packet arrived from source and being queued at SFU" << endl;
                 queue_TC2.insert(pkt);
                 //queue_TC3.insert(pkt);
-                pending_buffer_TC2 += pkt->getByteLength();
-                //pending_buffer_TC3 += pkt->getByteLength();
 
-                //EV << getFullName() << " Current TC2 queue length = " << queue_TC2.getLength() << " at SFU = " << getIndex() <<endl;
-                //EV << getFullName() << " Current buffer length = " << pending_buffer_TC2 << " at SFU = " << getIndex() <<endl;
-            }
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"hmd_data") == 0) {                    // background traffic is considered for T-CONT 3
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-            double buffer = pending_buffer_TC1 + pending_buffer_TC2 + pending_buffer_TC3 + pkt->getByteLength();      // future buffer size if current packet is queued
-            if(buffer <= sfu_buffer_capacity) {                             // queue the current packet if there is buffer capacity
-                pkt->setSfuArrivalTime(pkt->getArrivalTime());
-                pkt->setSfuId(getIndex());
-                pkt->setTContId(2);                 // for TC-2
-                //pkt->setTContId(3);               // for TC-3
-                //EV << getFullName() << " Packet arrived from source and being queued at SFU" << endl;
-                queue_TC2.insert(pkt);
-                //queue_TC3.insert(pkt);
-                pending_buffer_TC2 += pkt->getByteLength();
-                //pending_buffer_TC3 += pkt->getByteLength();
+                // T-CONT 2 burst still in progress: append the packet and push back the start of T-CONT 3
+                if(send_ul_payload_TC3->isScheduled() && (sfu_grant_TC2 > 0)) {
+                    transmitBurst(queue_TC2, sfu_grant_TC2);
+                    rescheduleAt(burst_cursor, send_ul_payload_TC3);
+                }
 
                 //EV << getFullName() << " Current TC2 queue length = " << queue_TC2.getLength() << " at SFU = " << getIndex() <<endl;
-                //EV << getFullName() << " Current buffer length = " << pending_buffer_TC2 << " at SFU = " << getIndex() <<endl;
+                //EV << getFullName() << " Current buffer length = " << queue_TC2.getBytes() << " at SFU = " << getIndex() <<endl;
             }
-            //delete pkt;
+            break;
         }
-        else if(strcmp(msg->getName(),"control_data") == 0) {                    // background traffic is considered for T-CONT 3
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-            double buffer = pending_buffer_TC1 + pending_buffer_TC2 + pending_buffer_TC3 + pkt->getByteLength();      // future buffer size if current packet is queued
-            if(buffer <= sfu_buffer_capacity) {                             // queue the current packet if there is buffer capacity
-                pkt->setSfuArrivalTime(pkt->getArrivalTime());
-                pkt->setSfuId(getIndex());
-                pkt->setTContId(2);                 // for TC-2
-                //pkt->setTContId(3);               // for TC-3
-                //EV << getFullName() << " Packet arrived from source and being queued at SFU" << endl;
-                queue_TC2.insert(pkt);
-                //queue_TC3.insert(pkt);
-                pending_buffer_TC2 += pkt->getByteLength();
-                //pending_buffer_TC3 += pkt->getByteLength();
-
-                //EV << getFullName() << " Current TC2 queue length = " << queue_TC2.getLength() << " at SFU = " << getIndex() <<endl;
-                //EV << getFullName() << " Current buffer length = " << pending_buffer_TC2 << " at SFU = " << getIndex() <<endl;
-            }
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"haptic_data") == 0) {                    // background traffic is considered for T-CONT 3
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-            double buffer = pending_buffer_TC1 + pending_buffer_TC2 + pending_buffer_TC3 + pkt->getByteLength();      // future buffer size if current packet is queued
-            if(buffer <= sfu_buffer_capacity) {                             // queue the current packet if there is buffer capacity
-                pkt->setSfuArrivalTime(pkt->getArrivalTime());
-                pkt->setSfuId(getIndex());
-                pkt->setTContId(2);                 // for TC-2
-                //pkt->setTContId(3);               // for TC-3
-                //EV << getFullName() << " Packet arrived from source and being queued at SFU" << endl;
-                queue_TC2.insert(pkt);
-                //queue_TC3.insert(pkt);
-                pending_buffer_TC2 += pkt->getByteLength();
-                //pending_buffer_TC3 += pkt->getByteLength();
+        case GTC_HDR_DL: {
+            gtc_dl_header *pkt = check_and_cast<gtc_dl_header *>(msg);
+            simtime_t arr_time = pkt->getArrivalTime();
+            EV_DEBUG << getFullName() << " gtc_hdr_dl arrival time: " << arr_time << endl;
 
-                //EV << getFullName() << " Current TC2 queue length = " << queue_TC2.getLength() << " at SFU = " << getIndex() <<endl;
-                //EV << getFullName() << " Current buffer length = " << pending_buffer_TC2 << " at SFU = " << getIndex() <<endl;
+            if(standing_hdr != nullptr) {               // a new map ends the standing one from this cycle on
+                standing_end = std::min(standing_end, pkt->getSeqID());
+                if(send_ul_standing->isScheduled() && (standing_seq >= standing_end)) {
+                    cancelEvent(send_ul_standing);
+                }
             }
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"gtc_hdr_dl") == 0) {
-            gtc_header *pkt = check_and_cast<gtc_header *>(msg);
-            simtime_t arr_time = pkt->getArrivalTime();
-            EV << getFullName() << " gtc_hdr_dl arrival time: " << arr_time << endl;
 
             //int totalNodes = getParentModule()->getSubmodule("sfus", 0)->getVectorSize();
             int totalNodes = getParentModule()->par("NumberOfSFUs");
             int index =  getIndex() % totalNodes;
-            EV << getFullName() << " totalNodes = "<< totalNodes << ", actual id: "<< index << endl;
-            mfu_sfu_rtt = pkt->getMfu_sfu_rtt(index);
-            start_time_TC2 = pkt->getSfu_start_time_TC2(index);
+            EV_DEBUG << getFullName() << " totalNodes = "<< totalNodes << ", actual id: "<< index << endl;
+            const BandwidthMap& bw_map = pkt->getBwMap();
+            mfu_sfu_rtt = bw_map.rtt[index];
+            start_time_TC2 = bw_map.start_time_TC2[index];
 
-            EV << getFullName() << " mfu_sfu_rtt: " << mfu_sfu_rtt << ", start_time_TC2: " << start_time_TC2 << endl;
+            EV_DEBUG << getFullName() << " mfu_sfu_rtt: " << mfu_sfu_rtt << ", start_time_TC2: " << start_time_TC2 << endl;
 
-            simtime_t ul_tx_time = arr_time + (simtime_t)(max_polling_cycle + start_time_TC2 - mfu_sfu_rtt);      // if RTT > 125/2 usec, then multiply by 2, else 1
+            simtime_t ul_tx_time = arr_time + (simtime_t)(bw_map.tx_offset + start_time_TC2 - mfu_sfu_rtt);      // offset computed by the MFU from the worst RTT
             // - (pkt->getBitLength()/pon_link_datarate)
-            cMessage *send_ul_header = new cMessage("send_ul_header");    // send uplink data
-            scheduleAt(ul_tx_time, send_ul_header);
+            if(!send_ul_header->isScheduled()) {
+                scheduleAt(ul_tx_time, send_ul_header);
+            }
+            else {
+                ul_header_times.push_back(ul_tx_time);      // timer is still armed for an earlier cycle
+            }
+            timer_allocs_avoided++;
             //EV << getFullName() << " send_ul_header is scheduled at: " << ul_tx_time << endl;
 
             //delete pkt;
             gtc_dl_queue.insert(pkt);
+            break;
         }
-    }
-    else {      // if not packet but a message
-        if(strcmp(msg->getName(),"ping") == 0) {
+        case PING: {
             ping *png = check_and_cast<ping *>(msg);
             png->setSFU_id(getIndex());                 // the index will be re-adjusted at MFU
             send(png,"SpltGate_out");                                  // immediately send the ping message back
             EV << getFullName() << " Sending ping response from SFU-" << getIndex() << " at " << simTime() << endl;
+            break;
         }
-        else if(strcmp(msg->getName(),"send_ul_header") == 0) {
-            cancelAndDelete(msg);         // delete the current instance of self-message
+        case SEND_UL_HEADER: {
+            if(!ul_header_times.empty()) {              // re-arm the timer for the next pending cycle
+                scheduleAt(ul_header_times.front(), send_ul_header);
+                ul_header_times.pop_front();
+            }
 
             gtc_hdr_sz = 3 + 1 + 1 + 5 + 8;                   // total size of GTC UL header: Preamble+Delim+BIP+PLOu_Header
             if(!gtc_dl_queue.isEmpty()) {
-                gtc_header *dl_hdr = (gtc_header *)gtc_dl_queue.pop();
+                gtc_dl_header *dl_hdr = (gtc_dl_header *)gtc_dl_queue.pop();
                 int totalNodes = getParentModule()->par("NumberOfSFUs");
                 int index =  getIndex() % totalNodes;
-                sfu_grant_TC2 = std::max(0.0,dl_hdr->getSfu_grant_TC2(index) - gtc_hdr_sz);
-                sfu_grant_TC3 = std::max(0.0,dl_hdr->getSfu_grant_TC3(index));
+                sfu_grant_TC2 = std::max(0.0,dl_hdr->getBwMap().grant_TC2[index] - gtc_hdr_sz);
+                sfu_grant_TC3 = std::max(0.0,dl_hdr->getBwMap().grant_TC3[index]);
                 seqID = dl_hdr->getSeqID();
-                delete dl_hdr;          // deleting the used gtc_dl_header
+                if(dl_hdr->getBwMap().standing) {
+                    startStandingReports(dl_hdr);       // the map stays valid for the following cycles
+                }
+                else {
+                    delete dl_hdr;          // deleting the used gtc_dl_header
+                }
             }
             else {
                 sfu_grant_TC2 = 0.0;
                 sfu_grant_TC3 = 0.0;
             }
 
-            gtc_header *gtc_hdr_ul = new gtc_header("gtc_hdr_ul");
-            gtc_hdr_ul->setByteLength(gtc_hdr_sz);
-            gtc_hdr_ul->setUplink(true);
-            gtc_hdr_ul->setSfuID(getIndex());
-            gtc_hdr_ul->setBufferOccupancyTC2(pending_buffer_TC2);
-            gtc_hdr_ul->setBufferOccupancyTC3(pending_buffer_TC3);
-
-            EV << getFullName() << " Sending gtc_hdr_ul from SFU-" << getIndex() << " at = " << simTime() << " for seqID = " << seqID << endl;
-            send(gtc_hdr_ul,"SpltGate_out");
+            sendReport();
 
-            simtime_t Txtime = (simtime_t)(gtc_hdr_ul->getBitLength()/int_pon_link_datarate);
-
-            cMessage *send_ul_payload = new cMessage("send_ul_payload_TC2");            // send uplink data
-            scheduleAt(gtc_hdr_ul->getSendingTime()+Txtime, send_ul_payload);
-            //EV << getFullName() << " send_ul_payload first time created and scheduled!" << endl;
-
-            //EV << getFullName() << " latest pending_buffer_TC3: " << pending_buffer_TC3 << endl;
+            //EV << getFullName() << " latest pending_buffer_TC3: " << queue_TC3.getBytes() << endl;
+            break;
         }
-        else if(strcmp(msg->getName(),"send_ul_payload_TC2") == 0) {
-            // for T-CONT 2
-            if((sfu_grant_TC2 > 0.0)&&(pending_buffer_TC2 > 0.0)&&(!msg->isScheduled())) {
-                if(!queue_TC2.isEmpty()) {
-                    ethPacket *front = (ethPacket *)queue_TC2.front();
-                    if(front->getByteLength() <= sfu_grant_TC2) {                // check if the first packet can be sent now
-                        ethPacket *data = (ethPacket *)queue_TC2.pop();          // pop and send the packet
-                        sfu_grant_TC2 = std::max(0.0, sfu_grant_TC2 - data->getByteLength());
-                        pending_buffer_TC2 = std::max(0.0, pending_buffer_TC2 - data->getByteLength());
-                        if(pending_buffer_TC2 < 1e-3)   // forcefully removing the numerical error
-                            pending_buffer_TC2 = 0.0;
-
-                        EV << getFullName() << " at " << simTime() << " Sending ul payload: " << data->getByteLength() << ", pending_buffer_TC2 = " << pending_buffer_TC2 << ", sfu_grant_TC2 = " << sfu_grant_TC2 << endl;
-                        send(data,"SpltGate_out");
-                        data->setSfuDepartureTime(data->getSendingTime());
-
-                        //double xr_packet_latency = data->getSfuDepartureTime().dbl() - data->getSfuArrivalTime().dbl();
-                        //EV << getFullName() << " packet_latency: " << packet_latency << endl;
-                        //emit(latencySignalXr, xr_packet_latency);
-
-                        // rescheduling send_ul_payload to send the consecutive queued packets
-                        simtime_t Txtime = (simtime_t)(data->getBitLength()/int_pon_link_datarate);
-                        scheduleAt(data->getSendingTime()+Txtime,msg);
-                        //EV << getFullName() << " send_ul_payload re-scheduled!" << endl;
-                    }
-                    else {      // if the remaining grant is insufficient to send the next packet
-                        //EV << "[sfu" << getIndex() << "] sfu_grant_TC2: " << sfu_grant_TC2 << " is insufficient to send a complete packet!" << endl;
-                        if (!queue_TC2.isEmpty()) {
-                            ethPacket *data = (ethPacket *)queue_TC2.pop();          // pop and send the packet
-                            double pkt_size = data->getByteLength();
-                            ethPacket *copy = data->dup();                            // creating a copy for all and sending immediately
-                            copy->setByteLength(sfu_grant_TC2);
-                            int fragment_count = data->getFragmentCount()+1;
-                            copy->setFragmentCount(fragment_count);
-                            data->setFragmentCount(fragment_count);
-
-                            send(copy,"SpltGate_out");
-                            copy->setSfuDepartureTime(copy->getSendingTime());
-
-                            data->setByteLength(pkt_size - sfu_grant_TC2);
-                            if(!queue_TC2.isEmpty()) {
-                                queue_TC2.insertBefore(queue_TC2.front(), data);
-                            }
-                            else {
-                                queue_TC2.insert(data);
-                            }
-                            //EV << getFullName() << " at " << simTime() << " sent fragmented packet of size: " << onu_grant_TC2 << " and en-queued packet of size = " << data->getByteLength() << endl;
-
-                            pending_buffer_TC2 = std::max(0.0, pending_buffer_TC2 - sfu_grant_TC2);
-                            if(pending_buffer_TC2 < 1e-3)   // forcefully removing the numerical error
-                                pending_buffer_TC2 = 0.0;
-                            sfu_grant_TC2 = 0.0;          // grant exhausted!
-
-                            //double xr_packet_latency = copy->getSfuDepartureTime().dbl() - copy->getSfuArrivalTime().dbl();
-                            //EV << getFullName() << " packet_latency: " << packet_latency << endl;
-                            //emit(latencySignalXr, xr_packet_latency);
-
-                            //delete msg;   // cleaning up packetSend msg
-                            simtime_t Txtime = (simtime_t)(copy->getBitLength()/int_pon_link_datarate);
-                            scheduleAt(copy->getSendingTime()+Txtime,msg);
-                            EV << getFullName() << " 246 ul TC2 transmission finished at: " << simTime() << " for seqID = " << seqID << endl;
-                        }
-                    }
-                }
-                else {
-                    delete msg;
-                    EV << getFullName() << " queue_TC2 is empty at: " << simTime() << endl;
-                }
-            }
-            else {  // either grant <= 0 or pending_buffer = 0
-                EV << getFullName() << " 254 ul TC2 transmission finished at: " << simTime() << " for seqID = " << seqID << endl;
-                delete msg;   // cleaning up packetSend msg
-
-                cMessage *send_ul_payload = new cMessage("send_ul_payload_TC3");            // send uplink data
-                scheduleAt(simTime(), send_ul_payload);
-            }
+        case SEND_UL_PAYLOAD_TC2: {
+            // for T-CONT 2: the whole burst is handed to the channel at once, departures follow back-to-back
+            burst_cursor = simTime();
+            transmitBurst(queue_TC2, sfu_grant_TC2);
+            EV_DEBUG << getFullName() << " ul TC2 transmission finishes at: " << burst_cursor << " for seqID = " << seqID << endl;
+
+            rescheduleAt(burst_cursor, send_ul_payload_TC3);        // T-CONT 3 starts when the T-CONT 2 burst is over
+            timer_allocs_avoided++;
+            break;
         }
-        else if(strcmp(msg->getName(),"send_ul_payload_TC3") == 0) {
+        case SEND_UL_PAYLOAD_TC3: {
             // for T-CONT 3
-            EV << getFullName() << " sfu_grant_TC3: " << sfu_grant_TC3 << ", pending_buffer_TC3 = " << pending_buffer_TC3 << ", msg->isScheduled(): " << msg->isScheduled() << endl;
-            if((sfu_grant_TC3 > 0)&&(pending_buffer_TC3 > 0)&&(!msg->isScheduled())) {
-                //EV << getFullName() << " queue_TC3.isEmpty(): " << queue_TC3.isEmpty() << endl;
-                if(!queue_TC3.isEmpty()) {
-                    ethPacket *front = (ethPacket *)queue_TC3.front();
-                    if(front->getByteLength() <= sfu_grant_TC3) {                // check if the first packet can be sent now
-                        ethPacket *data = (ethPacket *)queue_TC3.pop();          // pop and send the packet
-                        sfu_grant_TC3 = std::max(0.0, sfu_grant_TC3 - data->getByteLength());
-                        pending_buffer_TC3 = std::max(0.0, pending_buffer_TC3 - data->getByteLength());
-                        if(pending_buffer_TC3 < 1e-3)   // forcefully removing the numerical error
-                            pending_buffer_TC3 = 0.0;
-
-                        EV << getFullName() << " at " << simTime() << " Sending ul payload: " << data->getByteLength() << ", pending_buffer_TC3 = " << pending_buffer_TC3 << ", sfu_grant_TC3 = " << sfu_grant_TC3 << endl;
-                        send(data,"SpltGate_out");
-                        data->setSfuDepartureTime(data->getSendingTime());
-
-                        if(strcmp(data->getName(),"bkg_data") == 0) {
-                            //double bkg_packet_latency = data->getSfuDepartureTime().dbl() - data->getSfuArrivalTime().dbl();
-                            //EV << getFullName() << " packet_latency: " << packet_latency << endl;
-                            //emit(latencySignalBkg, bkg_packet_latency);
-                        }
-                        /*if(strcmp(data->getName(),"xr_data") == 0) {
-                            double xr_packet_latency = data->getSfuDepartureTime().dbl() - data->getSfuArrivalTime().dbl();
-                            //EV << getFullName() << " packet_latency: " << packet_latency << endl;
-                            emit(latencySignalXr, xr_packet_latency);
-                        }*/
-
-                        // rescheduling send_ul_payload to send the consecutive queued packets
-                        if(pending_buffer_TC3 > 0.0) {
-                            simtime_t Txtime = (simtime_t)(data->getBitLength()/int_pon_link_datarate);
-                            scheduleAt(data->getSendingTime()+Txtime,msg);
-                            //EV << getFullName() << " send_ul_payload re-scheduled!" << endl;
-                        }
-                        else {
-                            EV << getFullName() << " deleting msg @ 282" << endl;
-                            delete msg;
-                        }
-                    }
-                    else {      // if the remaining grant is insufficient to send the next packet
-                        //EV << "[sfu" << getIndex() << "] sfu_grant_TC3: " << sfu_grant_TC3 << " is insufficient to send a complete packet!" << endl;
-                        if (!queue_TC3.isEmpty()) {
-                            ethPacket *data = (ethPacket *)queue_TC3.pop();          // pop and send the packet
-                            double pkt_size = data->getByteLength();
-                            ethPacket *copy = data->dup();                            // creating a copy for all and sending immediately
-                            copy->setByteLength(sfu_grant_TC3);
-                            int fragment_count = data->getFragmentCount()+1;
-                            copy->setFragmentCount(fragment_count);
-                            data->setFragmentCount(fragment_count);
-
-                            send(copy,"SpltGate_out");
-                            copy->setSfuDepartureTime(copy->getSendingTime());
-
-                            data->setByteLength(pkt_size - sfu_grant_TC3);
-                            if(!queue_TC3.isEmpty()) {
-                                queue_TC3.insertBefore(queue_TC3.front(), data);
-                            }
-                            else {
-                                queue_TC3.insert(data);
-                            }
-                            //EV << getFullName() << " at " << simTime() << " sent fragmented packet of size: " << sfu_grant_TC3 << " and en-queued packet of size = " << data->getByteLength() << endl;
-
-                            pending_buffer_TC3 = std::max(0.0, pending_buffer_TC3 - sfu_grant_TC3);
-                            if(pending_buffer_TC3 < 1e-3)   // forcefully removing the numerical error
-                                pending_buffer_TC3 = 0.0;
-                            sfu_grant_TC3 = 0.0;          // grant exhausted!
-
-                            /*if(strcmp(data->getName(),"bkg_data") == 0) {
-                                double bkg_packet_latency = data->getSfuDepartureTime().dbl() - data->getSfuArrivalTime().dbl();
-                                //EV << getFullName() << " packet_latency: " << packet_latency << endl;
-                                emit(latencySignalBkg, bkg_packet_latency);
-                            }
-                            if(strcmp(data->getName(),"xr_data") == 0) {
-                                double xr_packet_latency = data->getSfuDepartureTime().dbl() - data->getSfuArrivalTime().dbl();
-                                //EV << getFullName() << " packet_latency: " << packet_latency << endl;
-                                emit(latencySignalXr, xr_packet_latency);
-                            }*/
-
-                            delete msg;   // cleaning up packetSend msg
-                            EV << getFullName() << " deleting msg @ 320" << endl;
-                            /*simtime_t Txtime = (simtime_t)(copy->getBitLength()/int_pon_link_datarate);
-                            scheduleAt(copy->getSendingTime()+Txtime,msg);*/
-                            EV << getFullName() << " 322 ul TC3 transmission finished at: " << simTime() << " for seqID = " << seqID << endl;
-                        }
-                    }
-                }
-                else {
-                    delete msg;
-                    EV << getFullName() << " queue_TC3 is empty at: " << simTime() << " deleting msg @ 329" << endl;
-                }
+            EV_DEBUG << getFullName() << " sfu_grant_TC3: " << sfu_grant_TC3 << ", pending_buffer_TC3 = " << queue_TC3.getBytes() << endl;
+            burst_cursor = simTime();
+            burst_last_start = simTime();
+            tc3_burst_open = transmitBurst(queue_TC3, sfu_grant_TC3);
+            EV_DEBUG << getFullName() << " ul TC3 transmission finishes at: " << burst_cursor << " for seqID = " << seqID << endl;
+            break;
+        }
+        case SEND_UL_STANDING: {        // cycle skipped by the idle scheduler, report with the standing map
+            int totalNodes = getParentModule()->par("NumberOfSFUs");
+            int index =  getIndex() % totalNodes;
+            gtc_hdr_sz = 3 + 1 + 1 + 5 + 8;                   // total size of GTC UL header: Preamble+Delim+BIP+PLOu_Header
+            sfu_grant_TC2 = std::max(0.0,standing_hdr->getBwMap().grant_TC2[index] - gtc_hdr_sz);
+            sfu_grant_TC3 = std::max(0.0,standing_hdr->getBwMap().grant_TC3[index]);
+            seqID = standing_seq;
+            sendReport();
+
+            if(standing_seq+1 < standing_end) {
+                standing_seq++;
+                scheduleAt(simTime()+max_polling_cycle, send_ul_standing);
             }
-            else {
-                    EV << getFullName() << " 332 ul TC3 transmission finished at: " << simTime() << " for seqID = " << seqID << endl;
-                    delete msg;   // cleaning up packetSend msg
-                    EV << getFullName() << " deleting msg @ 335" << endl;
+            break;
+        }
+        default:
+            EV << getFullName() << " Some unknown cMessage has arrived at = " << simTime() << endl;
+            delete msg;
+            break;
+    }
+}
+
+void SFU::finish()
+{
+    // every re-arm of a member timer used to be a fresh cMessage allocation
+    recordScalar("timer allocations avoided", timer_allocs_avoided);
+    if(simTime() > 0)
+        recordScalar("timer allocations avoided per second", timer_allocs_avoided/simTime().dbl());
+
+    // each of these cycles saved the send_ul_payload_TC2 and send_ul_payload_TC3 events
+    recordScalar("zero-grant cycles", zero_grant_cycles);
+
+    recordScalar("dropped packets", packet_drop_count);
+    recordScalar("dropped bytes", dropped_bytes);
+    recordScalar("queued bytes at end", queue_TC1.getBytes() + queue_TC2.getBytes() + queue_TC3.getBytes());
+    recordScalar("run unstable", (unstable_at >= 0) ? 1 : 0);
+    if(unstable_at >= 0)
+        recordScalar("unstable at", unstable_at);
+}
+
+/*
+ * Hands the queued packets of one T-CONT to the channel in a single step, as
+ * far as the grant allows. Every packet is sent with the delay at which the
+ * per-packet timer would have sent it, starting at burst_cursor. A packet that
+ * does not fit is not copied: a fragment descriptor covers the granted bytes
+ * and the queue remembers how much of its head packet is already on its way.
+ * Returns true if the burst ended with grant left, i.e. it may be extended by
+ * packets arriving before its last departure.
+ */
+bool SFU::transmitBurst(TContQueue& queue, double& grant)
+{
+    while((grant > 0) && !queue.isEmpty()) {
+        if(queue.getHeadBytes() <= grant) {                 // check if the (rest of the) first packet fits into the grant
+            long head_sent = queue.getHeadSent();
+            cPacket *data = queue.pop();
+            if(head_sent > 0) {                             // last piece of a fragmented packet
+                data->setByteLength(data->getByteLength() - head_sent);
             }
+            grant = std::max(0.0, grant - data->getByteLength());
+
+            EV_TRACE << getFullName() << " at " << burst_cursor << " Sending ul payload: " << data->getByteLength() << ", pending_buffer = " << queue.getBytes() << ", grant = " << grant << endl;
+            sendDelayed(data, burst_cursor - simTime(), "SpltGate_out");
+            ((ethPacket *)data)->setSfuDepartureTime(data->getSendingTime());
+
+            burst_last_start = burst_cursor;
+            burst_cursor += (simtime_t)(data->getBitLength()/int_pon_link_datarate);
+        }
+        else {      // if the remaining grant is insufficient to send the next packet
+            long frag_bytes = (long)grant;                              // whole bytes left in the grant
+            grant = 0;          // grant exhausted!
+            if(frag_bytes == 0)
+                return false;
+
+            ethPacket *head = (ethPacket *)queue.front();             // the SFU only queues packets from its WAP
+            ethFragment *frag = new ethFragment("fragment");          // describes the granted bytes, the packet stays queued
+            frag->setByteLength(frag_bytes);
+            int fragment_count = head->getFragmentCount()+1;
+            head->setFragmentCount(fragment_count);
+            frag->setPacketId(head->getSequenceNumber());
+            frag->setIndex(fragment_count);
+            frag->setOffset(queue.getHeadSent());
+            frag->setTContId(head->getTContId());
+            queue.consumeHead(frag_bytes);
+
+            sendDelayed(frag, burst_cursor - simTime(), "SpltGate_out");
+            //EV << getFullName() << " at " << burst_cursor << " sent fragment of size: " << frag_bytes << ", " << queue.getHeadBytes() << " bytes of the packet left" << endl;
+
+            burst_last_start = burst_cursor;
+            burst_cursor += (simtime_t)(frag->getBitLength()/int_pon_link_datarate);
+            return false;
         }
     }
+    return (grant > 0);
 }
 
+/*
+ * Sends the buffer report of the current cycle and starts the payload stage
+ * with the grants taken from the bandwidth map. Without any grant the payload
+ * stage would not send anything, so it is left out altogether.
+ */
+void SFU::sendReport()
+{
+    checkStability();           // once per cycle, the report time is a good sampling point
 
+    gtc_header *gtc_hdr_ul = new gtc_header("gtc_hdr_ul", GTC_HDR_UL);
+    gtc_hdr_ul->setByteLength(gtc_hdr_sz);
+    gtc_hdr_ul->setUplink(true);
+    gtc_hdr_ul->setSfuID(getIndex());
+    gtc_hdr_ul->setBufferOccupancyTC2(queue_TC2.getBytes());
+    gtc_hdr_ul->setBufferOccupancyTC3(queue_TC3.getBytes());
 
+    EV_DEBUG << getFullName() << " Sending gtc_hdr_ul from SFU-" << getIndex() << " at = " << simTime() << " for seqID = " << seqID << endl;
+    send(gtc_hdr_ul,"SpltGate_out");
 
+    if(zero_grant_fast_path && (sfu_grant_TC2 <= 0) && (sfu_grant_TC3 <= 0)) {     // nothing to send, the report is the whole cycle
+        if(send_ul_payload_TC2->isScheduled()) {
+            cancelEvent(send_ul_payload_TC2);
+        }
+        tc3_burst_open = false;
+        zero_grant_cycles++;
+        return;
+    }
+
+    simtime_t Txtime = (simtime_t)(gtc_hdr_ul->getBitLength()/int_pon_link_datarate);
+
+    rescheduleAt(gtc_hdr_ul->getSendingTime()+Txtime, send_ul_payload_TC2);
+    timer_allocs_avoided++;
+    //EV << getFullName() << " send_ul_payload first time created and scheduled!" << endl;
+}
+
+/*
+ * A standing map is repeated by the idle scheduler for every cycle until it
+ * sends a new header. Reports for those cycles follow one polling cycle apart,
+ * exactly where the reports for the skipped headers would have been sent.
+ */
+void SFU::startStandingReports(gtc_dl_header *dl_hdr)
+{
+    delete standing_hdr;
+    standing_hdr = dl_hdr;
+    standing_seq = dl_hdr->getSeqID() + 1;
+    standing_end = LONG_MAX;
+    if(!gtc_dl_queue.isEmpty()) {           // the next map has already arrived
+        standing_end = ((gtc_dl_header *)gtc_dl_queue.front())->getSeqID();
+    }
+    if(standing_seq < standing_end) {
+        scheduleAt(simTime()+max_polling_cycle, send_ul_standing);
+    }
+}
+
+/*
+ * Makes room for pkt in the buffer shared by all T-CONTs. With head drop the
+ * oldest packets of the same T-CONT go first, except a head packet that is
+ * already partly sent. A packet that still does not fit is dropped itself.
+ * Returns false if pkt was dropped.
+ */
+bool SFU::admit(cPacket *pkt, TContQueue& queue)
+{
+    long buffer = queue_TC1.getBytes() + queue_TC2.getBytes() + queue_TC3.getBytes();      // current buffer occupancy
+    if(head_drop) {
+        while((buffer + pkt->getByteLength() > capacity) && !queue.isEmpty() && (queue.getHeadSent() == 0)) {
+            cPacket *oldest = queue.pop();
+            buffer -= oldest->getByteLength();
+            discard(oldest);
+        }
+    }
+    if(buffer + pkt->getByteLength() > capacity) {
+        discard(pkt);
+        return false;
+    }
+    return true;
+}
+
+void SFU::discard(cPacket *pkt)
+{
+    packet_drop_count++;
+    dropped_bytes += pkt->getByteLength();
+    drop(pkt);
+    eth_packet_pool.release((ethPacket *)pkt);          // hand the packet back to the sources
+}
+
+/*
+ * Overload detector: compares the backlog (queued plus dropped bytes, so that a
+ * full buffer still counts as growth) with the previous window. When it grows
+ * faster than maxQueueGrowth for instabilityWindows windows in a row, the load
+ * point is not stable and the run is ended instead of running to the time limit.
+ */
+void SFU::checkStability()
+{
+    if((max_queue_growth <= 0) || (simTime() - last_check < instability_window))
+        return;
+
+    double backlog = queue_TC1.getBytes() + queue_TC2.getBytes() + queue_TC3.getBytes() + dropped_bytes;
+    double growth = (backlog - last_backlog)/(simTime() - last_check).dbl();        // bytes/s
+    last_check = simTime();
+    last_backlog = backlog;
+
+    if(growth > max_queue_growth)
+        unstable_windows++;
+    else
+        unstable_windows = 0;
+
+    if(unstable_windows >= instability_windows) {
+        unstable_at = simTime();
+        EV_WARN << getFullName() << " UNSTABLE: backlog growing at " << growth << " B/s for " << unstable_windows << " windows, ending the run at " << simTime() << endl;
+        endSimulation();
+    }
+}
+
+/*
+ * statsReset: a forked branch starts here, so the drop and zero-grant counts
+ * of the common part before the fork are forgotten.
+ */
+void SFU::receiveSignal(cComponent *source, simsignal_t signal, bool b, cObject *details)
+{
+    if(signal != stats_reset)
+        return;
+    packet_drop_count = 0;
+    dropped_bytes = 0;
+    zero_grant_cycles = 0;
+}
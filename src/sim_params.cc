@@ -24,8 +24,6 @@ int const pkt_sz_max = 1542;                                            // Ether
 //int const pkt_sz_max = 1000;                                          // for testing 1:16 1-GPON without fragmentation
 int pkt_sz_avg = ceil((pkt_sz_min + pkt_sz_max)/2);                     // Average packet size (bytes)
 
-double onu_buffer_capacity = 100e9;                                     // ONU buffer capacity (bytes)
-double sfu_buffer_capacity = 50e9;                                      // SFU buffer capacity (bytes)
 double T_guard = 1e-6;                                                  // guard time for each ONU
 
 double wifi_ofdma_slot = 1e-3;                                          // time duration of each OFDMA slot
@@ -18,8 +18,6 @@ extern int const pkt_sz_min;                  // Ethernet packet size - minimum
 extern int const pkt_sz_max;                  // Ethernet packet size - maximum (bytes)
 extern int pkt_sz_avg;                        // Average packet size (bytes)
 
-extern double onu_buffer_capacity;            // ONU buffer capacity (bytes)
-extern double sfu_buffer_capacity;            // SFU buffer capacity (bytes)
 extern double T_guard;                        // guard time for each ONU
 
 extern double wifi_ofdma_slot;                // time duration of each OFDMA slot
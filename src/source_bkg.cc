@@ -17,6 +17,10 @@
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
+#include "packet_pool.h"
+#include "distance_table.h"
 
 using namespace std;
 using namespace omnetpp;
@@ -30,10 +34,10 @@ class Background_Device : public cSimpleModule
     double pkt_interval;
     double wireless_datarate;
     double wap_dist;
-    vector<double> dist_values;
 
     cMessage *generateEvent = nullptr;
     cMessage *sendEvent = nullptr;
+    cGate *wap_gate = nullptr;     // input of the WAP, looked up once in initialize()
 
   public:
     virtual ~Background_Device();
@@ -42,6 +46,7 @@ class Background_Device : public cSimpleModule
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
     virtual ethPacket *generateNewPacket();
+    virtual void handleParameterChange(const char *parname) override;
 };
 
 Define_Module(Background_Device);
@@ -61,25 +66,9 @@ void Background_Device::initialize()
 {
     wireless_datarate = par("throughput").doubleValue();
 
-    std::ifstream file;
-    if(dist_values.empty()) {
-        if(strcmp(this->getName(),"bkgs1") == 0) {
-            file.open("ap_bkg1.csv");
-        }
-        else if(strcmp(this->getName(),"bkgs2") == 0) {
-            file.open("ap_bkg2.csv");
-        }
-        else if(strcmp(this->getName(),"bkgs3") == 0) {
-            file.open("ap_bkg3.csv");
-        }
-        double value;
-        while(file >> value) {
-            dist_values.push_back(value);
-        }
-    }
+    const vector<double>& distances = wap_distance_tables.get(par("distanceFile").stdstringValue());
     int idx = getIndex();
-    wap_dist = (idx < (int)dist_values.size()) ? dist_values[idx] : par("wap_distance").doubleValue();
-    file.close();
+    wap_dist = (idx < (int)distances.size()) ? distances[idx] : par("wap_distance").doubleValue();
     //wap_dist = par("wap_distance").doubleValue();
 
     EV << getFullName() << " wap_distance = " << wap_dist << endl;
@@ -92,15 +81,22 @@ void Background_Device::initialize()
     EV << getFullName() << " wireless_datarate = " << wireless_datarate << ", wap_dist = " << wap_dist;
     EV << ", Load = " << Load << ", ArrivalRate = " << ArrivalRate << endl;
 
-    generateEvent = new cMessage("generateEvent");  // initializing here
-    sendEvent = new cMessage("sendEvent");          // initializing here
+    generateEvent = new cMessage("generateEvent", GENERATE_EVENT);  // initializing here
+    sendEvent = new cMessage("sendEvent", SEND_EVENT);          // initializing here
+
+    // the WAP is resolved once; sendDirect() cannot cross partitions, so with parsim it must be local
+    cModule *wap = getParentModule()->getSubmodule("waps", getIndex());
+    if(wap->isPlaceholder())
+        throw cRuntimeError("%s must be in the same partition as %s", getFullPath().c_str(), wap->getFullPath().c_str());
+    wap_gate = wap->gate("Src_in");
+
     // schedule first packet generation
     scheduleAt(simTime(), generateEvent);           // scheduling packet generation for the first time
 }
 
 void Background_Device::handleMessage(cMessage *msg)
 {
-    if(strcmp(msg->getName(),"generateEvent") == 0) {
+    if(msg->getKind() == GENERATE_EVENT) {
         // generate a packet and put into queue
         ethPacket *pkt = generateNewPacket();
         source_queue.insert(pkt);
@@ -108,31 +104,30 @@ void Background_Device::handleMessage(cMessage *msg)
         // schedule next packet generation
         pkt_interval = exponential(1/ArrivalRate);
         scheduleAt(simTime() + pkt_interval, generateEvent);
-        EV << getFullName() << " Next packet generation is scheduled at = " << simTime()+pkt_interval << endl;
+        EV_TRACE << getFullName() << " Next packet generation is scheduled at = " << simTime()+pkt_interval << endl;
 
         // send packet if the channel is free
         if (!sendEvent->isScheduled()) {        // if no transmission is happening
             scheduleAt(simTime(), sendEvent);   // schedule send event immediately
         }
     }
-    else if(strcmp(msg->getName(),"sendEvent") == 0) {
+    else if(msg->getKind() == SEND_EVENT) {
         if(!source_queue.isEmpty()) {
             // dequeue next packet
             ethPacket *pkt = check_and_cast<ethPacket *>(source_queue.pop());
 
-            cModule *targetModule = getParentModule()->getSubmodule("waps", getIndex());
             // compute delays
             simtime_t propDelay = wap_dist / (3e8);
             simtime_t txDuration = pkt->getBitLength() / wireless_datarate;
             // send it
-            sendDirect(pkt, propDelay, txDuration, targetModule->gate("Src_in"));
-            //sendDirect(pkt, 0, 0, targetModule->gate("Src_in"));
+            sendDirect(pkt, propDelay, txDuration, wap_gate);
+            //sendDirect(pkt, 0, 0, wap_gate);
             scheduleAt(simTime()+txDuration, sendEvent);
-            EV << getFullName() << " Sent background packet at = " << simTime();
-            EV << " and next packet will be sent at = " << simTime()+txDuration << endl;
+            EV_TRACE << getFullName() << " Sent background packet at = " << simTime();
+            EV_TRACE << " and next packet will be sent at = " << simTime()+txDuration << endl;
         }
         else {
-            EV << getFullName() << " Queue is empty now!" << endl;
+            EV_TRACE << getFullName() << " Queue is empty now!" << endl;
             // no need to re-schedule sendEvent in this case.
         }
     }
@@ -141,9 +136,21 @@ void Background_Device::handleMessage(cMessage *msg)
 ethPacket *Background_Device::generateNewPacket()
 {
     int pkt_size = intuniform(64,1542);
-    ethPacket *pkt = new ethPacket("bkg_data");
+    ethPacket *pkt = eth_packet_pool.acquire("bkg_data", BKG_DATA);      // recycled from the OLT whenever possible
+    if(pkt->getOwner() != this)
+        take(pkt);
     pkt->setByteLength(pkt_size);
     pkt->setGenerationTime(simTime());
     //EV << getFullName() << " New packet generated with size (bytes): " << avgPacketSize << endl;
     return pkt;
 }
+
+// load may change while the simulation runs, e.g. in a branch forked by the OLT
+void Background_Device::handleParameterChange(const char *parname)
+{
+    if(strcmp(parname, "load") == 0) {
+        Load = par("load").doubleValue();
+        ArrivalRate = Load*par("dataRate").doubleValue()/(8*pkt_sz_avg);
+        EV << getFullName() << " Load changed to " << Load << ", ArrivalRate = " << ArrivalRate << endl;
+    }
+}
@@ -17,6 +17,10 @@
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
+#include "packet_pool.h"
+#include "distance_table.h"
 
 using namespace std;
 using namespace omnetpp;
@@ -38,10 +42,10 @@ class Haptic_Device : public cSimpleModule
         double pkt_interval;                     // inter-packet generation interval
         double wireless_datarate;
         double wap_dist;
-        vector<double> dist_values;
 
         cMessage *generateEvent = nullptr;
         cMessage *sendEvent = nullptr;
+        cGate *wap_gate = nullptr;     // input of the WAP, looked up once in initialize()
 
     public:
         virtual ~Haptic_Device();
@@ -70,16 +74,9 @@ void Haptic_Device::initialize()
 {
     wireless_datarate = par("throughput").doubleValue();
 
-    std::ifstream file("ap_hpt.csv");
-    if(dist_values.empty()) {
-        double value;
-        while(file >> value) {
-            dist_values.push_back(value);
-        }
-    }
+    const vector<double>& distances = wap_distance_tables.get(par("distanceFile").stdstringValue());
     int idx = getIndex();
-    wap_dist = (idx < (int)dist_values.size()) ? dist_values[idx] : par("wap_distance").doubleValue();
-    file.close();
+    wap_dist = (idx < (int)distances.size()) ? distances[idx] : par("wap_distance").doubleValue();
     //wap_dist = par("wap_distance").doubleValue();
     EV << getFullName() << " wap_distance = " << wap_dist << endl;
 
@@ -98,9 +95,15 @@ void Haptic_Device::initialize()
 
     pkt_interval = pareto_shifted(a, b, c);                      // packet inter-arrival times are generated following GP distribution
 
-    generateEvent = new cMessage("generateEvent");              // self-message is generated for next packet generation
+    generateEvent = new cMessage("generateEvent", GENERATE_EVENT);              // self-message is generated for next packet generation
     //emit(arrivalSignal,pkt_interval);
-    sendEvent = new cMessage("sendEvent");          // initializing here
+    sendEvent = new cMessage("sendEvent", SEND_EVENT);          // initializing here
+
+    // the WAP is resolved once; sendDirect() cannot cross partitions, so with parsim it must be local
+    cModule *wap = getParentModule()->getSubmodule("waps", getIndex()*2);
+    if(wap->isPlaceholder())
+        throw cRuntimeError("%s must be in the same partition as %s", getFullPath().c_str(), wap->getFullPath().c_str());
+    wap_gate = wap->gate("Src_in");
 
     // schedule first packet generation
     scheduleAt(simTime(), generateEvent);
@@ -108,7 +111,7 @@ void Haptic_Device::initialize()
 
 void Haptic_Device::handleMessage(cMessage *msg)
 {
-    if(strcmp(msg->getName(),"generateEvent") == 0) {
+    if(msg->getKind() == GENERATE_EVENT) {
         // generate a packet and put into queue
         ethPacket *pkt = generateNewPacket();
         source_queue.insert(pkt);
@@ -123,31 +126,30 @@ void Haptic_Device::handleMessage(cMessage *msg)
 
         pkt_interval = pareto_shifted(a, b, c);                      // packet inter-arrival times are generated following GP distribution
         scheduleAt(simTime() + pkt_interval, generateEvent);      // scheduling the next packet generation
-        EV << getFullName() << " Next packet generation is scheduled at = " << simTime()+pkt_interval << endl;
+        EV_TRACE << getFullName() << " Next packet generation is scheduled at = " << simTime()+pkt_interval << endl;
 
         // send packet if the channel is free
         if (!sendEvent->isScheduled()) {        // if no transmission is happening
             scheduleAt(simTime(), sendEvent);   // schedule send event immediately
         }
     }
-    else if(strcmp(msg->getName(),"sendEvent") == 0) {
+    else if(msg->getKind() == SEND_EVENT) {
         if(!source_queue.isEmpty()) {
             // dequeue next packet
             ethPacket *pkt = check_and_cast<ethPacket *>(source_queue.pop());
 
-            cModule *targetModule = getParentModule()->getSubmodule("waps", (getIndex()*2));
             // compute delays
             simtime_t propDelay = wap_dist / (3e8);
             simtime_t txDuration = pkt->getBitLength() / wireless_datarate;
             // send it
-            sendDirect(pkt, propDelay, txDuration, targetModule->gate("Src_in"));
-            //sendDirect(pkt, 0, 0, targetModule->gate("Src_in"));
+            sendDirect(pkt, propDelay, txDuration, wap_gate);
+            //sendDirect(pkt, 0, 0, wap_gate);
             scheduleAt(simTime()+txDuration, sendEvent);
-            EV << getFullName() << " Sent Haptic packet at = " << simTime();
-            EV << " and next packet will be sent at = " << simTime()+txDuration << endl;
+            EV_TRACE << getFullName() << " Sent Haptic packet at = " << simTime();
+            EV_TRACE << " and next packet will be sent at = " << simTime()+txDuration << endl;
         }
         else {
-            EV << getFullName() << " Queue is empty now!" << endl;
+            EV_TRACE << getFullName() << " Queue is empty now!" << endl;
             // no need to re-schedule sendEvent in this case.
         }
     }
@@ -155,7 +157,9 @@ void Haptic_Device::handleMessage(cMessage *msg)
 
 ethPacket *Haptic_Device::generateNewPacket()
 {
-    ethPacket *pkt = new ethPacket("haptic_data");
+    ethPacket *pkt = eth_packet_pool.acquire("haptic_data", HAPTIC_DATA);      // recycled from the OLT whenever possible
+    if(pkt->getOwner() != this)
+        take(pkt);
     pkt->setByteLength(avgPacketSize);                              // generating packets of same size
     pkt->setGenerationTime(simTime());
     //EV << getFullName() << " New packet generated with size (bytes): " << avgPacketSize << endl;
@@ -15,6 +15,10 @@
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
+#include "output_port.h"
+#include "bw_map.h"
 
 using namespace std;
 using namespace omnetpp;
@@ -22,11 +26,11 @@ using namespace omnetpp;
 class Splitter : public cSimpleModule
 {
     private:
-        cQueue onu_queue;            // Queue for packets to be sent to ONUs
-        cQueue olt_queue;            // Queue for packets to be sent to OLT
-        double onu_queue_size;
-        double olt_queue_size;
-        double pon_datarate;
+        vector<OutputPort *> onu_ports;     // FIFO output ports towards the ONUs
+        OutputPort olt_port;                // FIFO output port towards the OLT
+
+    public:
+        virtual ~Splitter();
 
     protected:
        // The following redefined virtual function holds the algorithm.
@@ -36,22 +40,26 @@ class Splitter : public cSimpleModule
 
 Define_Module(Splitter);
 
+Splitter::~Splitter()
+{
+    for (OutputPort *port : onu_ports) {
+        delete port;
+    }
+}
+
 void Splitter::initialize()
 {
-    onu_queue.setName("onu_queue");
-    olt_queue.setName("olt_queue");
-    olt_queue_size = 0;
-    onu_queue_size = 0;
+    olt_port.init(this, gate("OltGate_o"), "OLT_Tx_Delay", OLT_TX_DELAY);
 
-    cGate *g = gate("OltGate_o");                   // get the gate
-    cChannel *ch = g->getChannel();                 // get the channel object
-    if (ch != nullptr) {
-        pon_datarate = ch->par("datarate").doubleValue();  // in bits per second
+    int n = gateSize("OnuGate_o");
+    for (int k = 0; k < n; k++) {
+        OutputPort *port = new OutputPort();
+        port->init(this, gate("OnuGate_o",k), "ONU_Tx_Delay", ONU_TX_DELAY);
+        onu_ports.push_back(port);
     }
 
     // Make sure incoming message is delivered immediately
     gate("OltGate_i")->setDeliverImmediately(true);
-    int n = gateSize("OnuGate_o");
     for (int k = 0; k < n; k++) {
         gate("OnuGate_i",k)->setDeliverImmediately(true);
     }
@@ -59,158 +67,41 @@ void Splitter::initialize()
 
 void Splitter::handleMessage(cMessage *msg)
 {
-    if(msg->isPacket() == true) {
-        //EV << "[splt] input received as packet!" << endl;
-        if(msg->arrivedOn("OltGate_i") == true) {     // any message arriving from OLT are broadcasted to all ONUs
-            if(strcmp(msg->getName(),"gtc_hdr_dl") == 0) {
-                gtc_header *pkt = check_and_cast<gtc_header *>(msg);
-                //EV << "[splt] gtc_hdr_dl received at OltGate_i" << endl;
-                int n = gateSize("OnuGate_o");
-                for (int k = 0; k < n; k++) {
-                    //EV << "[splt] sending packet to ONU-"<< k <<" at "<< simTime() << endl;
-                    cGate *onu_gate = gate("OnuGate_o",k);
-                    cChannel *onu_ch = onu_gate->getChannel();
-                    if((onu_ch->isBusy() == false)&&(onu_queue.getLength() == 0)) {
-                        gtc_header *copy = pkt->dup();       // creating a copy for all and sending immediately
-                        send(copy,"OnuGate_o",k);
-                    }
-                    else {
-                        gtc_header *copy = pkt->dup();
-                        if(pkt->getExt_pon())
-                            copy->setOnuID(k);                  // set the OnuID with the current value k
-                        else if(pkt->getInt_pon())
-                            copy->setSfuID(k);
-                        onu_queue.insert(copy);
-
-                        cMessage *onu_tx = new cMessage("ONU_Tx_Delay");
-                        scheduleAt(onu_ch->getTransmissionFinishTime()+(simtime_t)(onu_queue_size*8/pon_datarate),onu_tx);
-                        onu_queue_size += copy->getByteLength();
-                    }
-                }
-                delete pkt;
+    switch(msg->getKind()) {
+        case GTC_HDR_DL: {     // any gtc_hdr_dl arriving from OLT is broadcasted to all ONUs
+            gtc_dl_header *pkt = check_and_cast<gtc_dl_header *>(msg);
+            //EV << "[splt] gtc_hdr_dl received at OltGate_i" << endl;
+            int n = onu_ports.size();
+            for (int k = 0; k < n; k++) {
+                //EV << "[splt] sending packet to ONU-"<< k <<" at "<< simTime() << endl;
+                gtc_dl_header *copy = pkt->dup();    // copies share the bandwidth map, sent as soon as the ONU channel is free
+                onu_ports[k]->send(copy);
             }
+            delete pkt;
+            break;
         }
-        else if(msg->arrivedOn("OnuGate_i") == true){
-            cGate *olt_gate = gate("OltGate_o");
-            cChannel *olt_ch = olt_gate->getChannel();
-            if((olt_ch->isBusy() == false)&&(olt_queue.getLength() == 0)) {
-                send(msg,"OltGate_o");
-                //EV << "[splt] 76 sending packet to OLT at "<< simTime() << endl;
-            }
-            else {
-                EV << "[splt] channel busy so queuing for OLT at "<< simTime() << endl;
-                if (strcmp(msg->getName(), "gtc_hdr_ul") == 0) {
-                    gtc_header *pkt = check_and_cast<gtc_header *>(msg);
-                    olt_queue.insert(pkt);
-
-                    cMessage *olt_tx = new cMessage("OLT_Tx_Delay");
-                    scheduleAt(olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate),olt_tx);
-                    olt_queue_size += pkt->getByteLength();
-                    EV << "[splt] gtc_hdr_ul queued; OLT_Tx_Delay at: " << olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate) << ", Queue size = " << olt_queue_size << endl;
-                }
-
-                if (strcmp(msg->getName(), "bkg_data") == 0) {
-                    ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-                    olt_queue.insert(pkt);
-
-                    cMessage *olt_tx = new cMessage("OLT_Tx_Delay");
-                    scheduleAt(olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate),olt_tx);
-                    olt_queue_size += pkt->getByteLength();
-                    EV << "[splt] bkg data packet queued; OLT_Tx_Delay at: " << olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate) << ", Queue size = " << olt_queue_size << endl;
-                }
-                else if (strcmp(msg->getName(), "xr_data") == 0) {
-                    ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-                    olt_queue.insert(pkt);
-
-                    cMessage *olt_tx = new cMessage("OLT_Tx_Delay");
-                    scheduleAt(olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate),olt_tx);
-                    olt_queue_size += pkt->getByteLength();
-                    EV << "[splt] bkg data packet queued; OLT_Tx_Delay at: " << olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate) << ", Queue size = " << olt_queue_size << endl;
-                }
-                else if (strcmp(msg->getName(), "hmd_data") == 0) {
-                    ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-                    olt_queue.insert(pkt);
-
-                    cMessage *olt_tx = new cMessage("OLT_Tx_Delay");
-                    scheduleAt(olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate),olt_tx);
-                    olt_queue_size += pkt->getByteLength();
-                    EV << "[splt] bkg data packet queued; OLT_Tx_Delay at: " << olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate) << ", Queue size = " << olt_queue_size << endl;
-                }
-                else if (strcmp(msg->getName(), "control_data") == 0) {
-                    ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-                    olt_queue.insert(pkt);
-
-                    cMessage *olt_tx = new cMessage("OLT_Tx_Delay");
-                    scheduleAt(olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate),olt_tx);
-                    olt_queue_size += pkt->getByteLength();
-                    EV << "[splt] bkg data packet queued; OLT_Tx_Delay at: " << olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate) << ", Queue size = " << olt_queue_size << endl;
-                }
-                else if (strcmp(msg->getName(), "haptic_data") == 0) {
-                    ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-                    olt_queue.insert(pkt);
-
-                    cMessage *olt_tx = new cMessage("OLT_Tx_Delay");
-                    scheduleAt(olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate),olt_tx);
-                    olt_queue_size += pkt->getByteLength();
-                    EV << "[splt] bkg data packet queued; OLT_Tx_Delay at: " << olt_ch->getTransmissionFinishTime()+(simtime_t)(olt_queue_size*8/pon_datarate) << ", Queue size = " << olt_queue_size << endl;
-                }
+        case GTC_HDR_UL:
+        case BKG_DATA:
+        case XR_DATA:
+        case HMD_DATA:
+        case CONTROL_DATA:
+        case HAPTIC_DATA:
+        case ETH_FRAGMENT: {   // any packet arriving from any ONU is sent to the OLT
+            cPacket *pkt = check_and_cast<cPacket *>(msg);
+            olt_port.send(pkt);
+            if(olt_port.getQueueLength() > 0) {
+                EV_TRACE << "[splt] channel busy so queuing " << pkt->getName() << " for OLT at "<< simTime() << ", Queue size = " << olt_port.getQueuedBytes() << endl;
             }
+            break;
         }
-    }
-    else {
-        if(msg->isSelfMessage()) {
-            if(strcmp(msg->getName(),"OLT_Tx_Delay") == 0) {
-                EV << "[splt] OLT_Tx_Delay detected!"<< endl;
-                cancelAndDelete(msg);
-
-                if(strcmp(olt_queue.front()->getName(),"gtc_hdr_ul") == 0) {
-                    EV << "[splt] sending gtc_hdr_ul packet to OLT at "<< simTime() << endl;
-                    gtc_header *pkt = (gtc_header *)olt_queue.pop();
-                    send(pkt,"OltGate_o");
-                    EV << "[splt] Sent delayed gtc_hdr_ul at: " << simTime() << endl;
-                    olt_queue_size -= pkt->getByteLength();
-                }
-                if(strcmp(olt_queue.front()->getName(),"bkg_data") == 0) {
-                    EV << "[splt] sending bkg_data packet to OLT at "<< simTime() << endl;
-                    ethPacket *pkt = (ethPacket *)olt_queue.pop();
-                    send(pkt,"OltGate_o");
-                    EV << "[splt] Sent delayed bkg_data at: " << simTime() << endl;
-                    olt_queue_size -= pkt->getByteLength();
-                }
-                if(strcmp(olt_queue.front()->getName(),"xr_data") == 0) {
-                    EV << "[splt] sending xr_data packet to OLT at "<< simTime() << endl;
-                    ethPacket *pkt = (ethPacket *)olt_queue.pop();
-                    send(pkt,"OltGate_o");
-                    EV << "[splt] Sent delayed xr_data at: " << simTime() << endl;
-                    olt_queue_size -= pkt->getByteLength();
-                }
-                if(strcmp(olt_queue.front()->getName(),"hmd_data") == 0) {
-                    EV << "[splt] sending hmd_data packet to OLT at "<< simTime() << endl;
-                    ethPacket *pkt = (ethPacket *)olt_queue.pop();
-                    send(pkt,"OltGate_o");
-                    EV << "[splt] Sent delayed hmd_data at: " << simTime() << endl;
-                    olt_queue_size -= pkt->getByteLength();
-                }
-                if(strcmp(olt_queue.front()->getName(),"control_data") == 0) {
-                    EV << "[splt] sending control_data packet to OLT at "<< simTime() << endl;
-                    ethPacket *pkt = (ethPacket *)olt_queue.pop();
-                    send(pkt,"OltGate_o");
-                    EV << "[splt] Sent delayed control_data at: " << simTime() << endl;
-                    olt_queue_size -= pkt->getByteLength();
-                }
-                if(strcmp(olt_queue.front()->getName(),"haptic_data") == 0) {
-                    EV << "[splt] sending haptic_data packet to OLT at "<< simTime() << endl;
-                    ethPacket *pkt = (ethPacket *)olt_queue.pop();
-                    send(pkt,"OltGate_o");
-                    EV << "[splt] Sent delayed haptic_data at: " << simTime() << endl;
-                    olt_queue_size -= pkt->getByteLength();
-                }
-            }
+        case OLT_TX_DELAY:
+        case ONU_TX_DELAY: {   // transmission finished on one of the output ports
+            OutputPort *port = (OutputPort *)msg->getContextPointer();
+            port->handleTxFinished();
+            break;
         }
-
-        //EV << "[splt] input received as message!" << endl;
-        if(msg->arrivedOn("OltGate_i") == true) {     // any message arriving from OLT are broadcasted to all ONUs
-            if(strcmp(msg->getName(),"ping") == 0) {
+        case PING: {
+            if(msg->arrivedOn("OltGate_i") == true) {     // any ping arriving from OLT is broadcasted to all ONUs
                 ping *png = check_and_cast<ping *>(msg);
                 //EV << "[splt] Ping received at OltGate_i" << endl;
                 int n = gateSize("OnuGate_o");
@@ -222,11 +113,15 @@ void Splitter::handleMessage(cMessage *msg)
                 }
                 delete png;
             }
+            else {                                      // any ping response arriving from any ONU is sent to the OLT
+                send(msg,"OltGate_o");
+                //EV << "[splt] Forwarding ping to OLT" << endl;
+            }
+            break;
         }
-        else {                                      // any message arriving from any ONU are sent to the OLT
-            send(msg,"OltGate_o");
-            //EV << "[splt] Forwarding ping to OLT" << endl;
-        }
+        default:
+            EV << "[splt] Some unknown cMessage has arrived at = " << simTime() << endl;
+            delete msg;
+            break;
     }
 }
-
@@ -0,0 +1,60 @@
+/*
+ * stopping_rule.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include <math.h>
+#include <algorithm>
+
+#include "stopping_rule.h"
+
+BatchMeansStopper::BatchMeansStopper(double quantile, long batch_size, int min_batches, double rel_width) :
+        quantile(quantile), batch_size(batch_size), min_batches(min_batches), rel_width(rel_width)
+{
+    if(batch_size < 1 || min_batches < 2)
+        throw cRuntimeError("BatchMeansStopper: needs batch_size >= 1 and min_batches >= 2");
+}
+
+bool BatchMeansStopper::collect(double value)
+{
+    if(quantile > 0)
+        batch_histogram.collect(value);
+    else
+        batch_sum += value;
+    if(++batch_fill < batch_size)
+        return false;
+
+    double batch_value = (quantile > 0) ? batch_histogram.getQuantile(quantile) : batch_sum/batch_size;
+    batch_histogram.clear();
+    batch_sum = 0;
+    batch_fill = 0;
+
+    batches++;
+    sum += batch_value;
+    sum_sq += batch_value*batch_value;
+    if(batches < min_batches)
+        return false;
+
+    // Student t quantile for 95%, Cornish-Fisher expansion around z = 1.96, within 0.1% from 5 degrees of freedom
+    double z = 1.959964;
+    double dof = batches - 1;
+    double t = z + (z*z*z + z)/(4*dof) + (5*pow(z,5) + 16*z*z*z + 3*z)/(96*dof*dof);
+
+    double mean = sum/batches;
+    double variance = std::max(0.0, (sum_sq - sum*mean)/dof);
+    half_width = t*sqrt(variance/batches);
+    return half_width < rel_width*fabs(mean);
+}
+
+void BatchMeansStopper::reset()
+{
+    batch_histogram.clear();
+    batch_sum = 0;
+    batch_fill = 0;
+    batches = 0;
+    sum = 0;
+    sum_sq = 0;
+    half_width = 0;
+}
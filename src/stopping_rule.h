@@ -0,0 +1,54 @@
+/*
+ * stopping_rule.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef STOPPING_RULE_H_
+#define STOPPING_RULE_H_
+
+#include <omnetpp.h>
+
+#include "hdr_histogram.h"
+
+using namespace omnetpp;
+
+/*
+ * Sequential stopping rule on the batch-means confidence interval. Samples are
+ * grouped in batches of batch_size. Each batch gives one value: its mean, or
+ * its quantile when quantile > 0. After every batch the 95% confidence interval
+ * over the batch values is updated. collect() returns true once its half width
+ * is below rel_width times the estimate. Batches must be long enough to be
+ * nearly independent, at least several times the correlation length of the
+ * latency.
+ */
+class BatchMeansStopper
+{
+    private:
+        double quantile;                        // 0 for the batch mean
+        long batch_size;
+        int min_batches;
+        double rel_width;
+
+        LogHistogram batch_histogram;
+        double batch_sum = 0;
+        long batch_fill = 0;
+
+        long batches = 0;
+        double sum = 0;                         // of the batch values
+        double sum_sq = 0;
+        double half_width = 0;
+
+    public:
+        BatchMeansStopper(double quantile, long batch_size, int min_batches, double rel_width);
+
+        bool collect(double value);             // true when the interval is narrow enough
+        void reset();                           // forget all batches, e.g. when a forked branch starts
+
+        long getBatches() const { return batches; }
+        double getEstimate() const { return (batches > 0) ? sum/batches : 0; }
+        double getHalfWidth() const { return half_width; }
+};
+
+#endif /* STOPPING_RULE_H_ */
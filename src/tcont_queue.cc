@@ -0,0 +1,52 @@
+/*
+ * tcont_queue.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include "tcont_queue.h"
+
+void TContQueue::grow()
+{
+    std::vector<cPacket *> larger(ring.size()*2, nullptr);
+    for(size_t i = 0; i < count; i++) {
+        larger[i] = ring[(first + i) & (ring.size() - 1)];
+    }
+    ring.swap(larger);
+    first = 0;
+}
+
+void TContQueue::insert(cPacket *pkt)
+{
+    if(count == ring.size())
+        grow();
+    ring[(first + count) & (ring.size() - 1)] = pkt;
+    count++;
+    bytes += pkt->getByteLength();
+    if(count == 1)
+        head_bytes = pkt->getByteLength();
+}
+
+cPacket *TContQueue::pop()
+{
+    if(count == 0)
+        throw cRuntimeError("TContQueue::pop(): queue is empty");
+
+    cPacket *pkt = ring[first];
+    ring[first] = nullptr;
+    first = (first + 1) & (ring.size() - 1);
+    count--;
+
+    bytes -= head_bytes;
+    head_sent = 0;
+    head_bytes = (count > 0) ? ring[first]->getByteLength() : 0;
+    return pkt;
+}
+
+void TContQueue::consumeHead(long n)
+{
+    head_sent += n;
+    head_bytes -= n;
+    bytes -= n;
+}
@@ -0,0 +1,51 @@
+/*
+ * tcont_queue.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef TCONT_QUEUE_H_
+#define TCONT_QUEUE_H_
+
+#include <vector>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/*
+ * T-CONT queue of the ONU and SFU: a contiguous ring buffer of packet pointers
+ * that grows by doubling. Unlike cQueue it takes no ownership, so the packets
+ * stay with the module and insert/pop are plain index updates. Queued bytes are
+ * counted exactly in integers, and the bytes left of the head packet are cached.
+ * A head packet partly sent as fragments stays queued, head_sent tells how much
+ * of it is already gone; those bytes no longer count as queued.
+ */
+class TContQueue
+{
+    private:
+        std::vector<cPacket *> ring;            // size is always a power of two
+        size_t first = 0;                       // position of the head packet
+        size_t count = 0;
+        long bytes = 0;                         // queued bytes not yet sent
+        long head_bytes = 0;                    // bytes of the head packet not yet sent
+        long head_sent = 0;                     // bytes of the head packet sent as fragments
+
+        void grow();
+
+    public:
+        TContQueue() : ring(16, nullptr) {}
+
+        void insert(cPacket *pkt);              // append at the tail
+        cPacket *pop();                         // remove the head packet, its length is not changed
+        void consumeHead(long n);               // n bytes of the head packet went out as a fragment
+
+        cPacket *front() const { return ring[first]; }
+        bool isEmpty() const { return count == 0; }
+        int getLength() const { return (int)count; }
+        long getBytes() const { return bytes; }
+        long getHeadBytes() const { return head_bytes; }
+        long getHeadSent() const { return head_sent; }
+};
+
+#endif /* TCONT_QUEUE_H_ */
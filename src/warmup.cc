@@ -0,0 +1,70 @@
+/*
+ * warmup.cc
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#include "warmup.h"
+
+MserDetector::MserDetector(simtime_t check_interval, int min_batches) : check_interval(check_interval), next_check(check_interval), min_batches(min_batches)
+{
+}
+
+bool MserDetector::collect(simtime_t now, double value)
+{
+    if(steady)
+        return true;
+
+    discarded++;
+    batch_sum += value;
+    if(++batch_fill == BATCH) {
+        means.push_back(batch_sum/BATCH);
+        ends.push_back(now);
+        batch_sum = 0;
+        batch_fill = 0;
+    }
+    if(now >= next_check) {
+        next_check = now + check_interval;
+        check(now);
+    }
+    return false;
+}
+
+/*
+ * MSER(d) = sum of (Y_i - mean)^2 over the batches after d, divided by (m-d)^2.
+ * Sums over the tail are built from the last batch backwards, so one check is
+ * linear in the number of batches.
+ */
+void MserDetector::check(simtime_t now)
+{
+    int m = means.size();
+    if(m < min_batches)
+        return;
+
+    double sum = 0, sum_sq = 0;
+    double best = -1;
+    int best_d = 0;
+    for(int d = m - 1; d >= 0; d--) {
+        sum += means[d];
+        sum_sq += means[d]*means[d];
+        if(d > m/2)
+            continue;
+        int n = m - d;
+        double mser = (sum_sq - sum*sum/n)/((double)n*n);
+        if((best < 0) || (mser <= best)) {
+            best = mser;
+            best_d = d;
+        }
+    }
+    if(best_d >= m/2)
+        return;                                 // still drifting, the minimum is at the edge of the search
+
+    steady = true;
+    truncation_time = (best_d > 0) ? ends[best_d - 1] : SIMTIME_ZERO;
+    steady_time = now;
+    means.clear();
+    means.shrink_to_fit();
+    ends.clear();
+    ends.shrink_to_fit();
+}
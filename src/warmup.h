@@ -0,0 +1,57 @@
+/*
+ * warmup.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: mondals
+ */
+
+#ifndef WARMUP_H_
+#define WARMUP_H_
+
+#include <vector>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/*
+ * MSER-5 warm-up detector. Samples are averaged in batches of 5, and at every
+ * check the truncation point d* minimising the MSER statistic of the batch
+ * means is searched in the first half of the data. Once d* falls inside the
+ * first half, the run is taken to be in steady state. From then on collect()
+ * accepts samples. Everything before is discarded, including the steady part
+ * between d* and the check, so the recorded results carry no start-up bias.
+ * Samples are not kept, so a class that never becomes steady before the end of
+ * the run, e.g. at an overloaded load point, has no latency results at all.
+ */
+class MserDetector
+{
+    private:
+        static const int BATCH = 5;
+        std::vector<double> means;              // batch means until steady state
+        std::vector<simtime_t> ends;            // time of the last sample of each batch
+        double batch_sum = 0;
+        int batch_fill = 0;
+
+        simtime_t check_interval;
+        simtime_t next_check;
+        int min_batches;
+
+        bool steady = false;
+        simtime_t truncation_time;              // end of batch d*, where steady state began
+        simtime_t steady_time;                  // when steady state was detected and recording began
+        long discarded = 0;
+
+        void check(simtime_t now);
+
+    public:
+        MserDetector(simtime_t check_interval = 0.05, int min_batches = 100);
+
+        bool collect(simtime_t now, double value);      // true if the sample is to be recorded
+
+        bool isSteady() const { return steady; }
+        simtime_t getTruncationTime() const { return truncation_time; }
+        simtime_t getSteadyTime() const { return steady_time; }
+        long getDiscarded() const { return discarded; }
+};
+
+#endif /* WARMUP_H_ */
@@ -15,6 +15,8 @@
 #include "ethPacket_m.h"
 #include "ping_m.h"
 #include "gtc_header_m.h"
+#include "msg_kinds.h"
+#include "log_level.h"
 
 using namespace std;
 using namespace omnetpp;
@@ -51,8 +53,12 @@ void WiFi_AP::initialize()
 
 void WiFi_AP::handleMessage(cMessage *msg)
 {
-    if(msg->isPacket() == true) {
-        if(strcmp(msg->getName(),"bkg_data") == 0) {                // updating buffer size after receiving requests from ONUs
+    switch(msg->getKind()) {
+        case BKG_DATA:
+        case XR_DATA:
+        case HMD_DATA:
+        case CONTROL_DATA:
+        case HAPTIC_DATA: {                                         // data from the wireless devices of all traffic classes
             ethPacket *pkt = check_and_cast<ethPacket *>(msg);
 
             pkt->setWapArrivalTime(pkt->getArrivalTime());
@@ -60,49 +66,11 @@ void WiFi_AP::handleMessage(cMessage *msg)
             pkt->setWapDepartureTime(pkt->getSendingTime());
 
             //delete pkt;
+            break;
         }
-        else if(strcmp(msg->getName(),"xr_data") == 0) {            // updating buffer size after receiving requests from ONUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            pkt->setWapArrivalTime(pkt->getArrivalTime());
-            send(pkt,"Sfu_out");                                    // just forward to SFU
-            pkt->setWapDepartureTime(pkt->getSendingTime());
-
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"hmd_data") == 0) {           // updating buffer size after receiving requests from ONUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            pkt->setWapArrivalTime(pkt->getArrivalTime());
-            send(pkt,"Sfu_out");                                    // just forward to SFU
-            pkt->setWapDepartureTime(pkt->getSendingTime());
-
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"control_data") == 0) {       // updating buffer size after receiving requests from ONUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            pkt->setWapArrivalTime(pkt->getArrivalTime());
-            send(pkt,"Sfu_out");                                    // just forward to SFU
-            pkt->setWapDepartureTime(pkt->getSendingTime());
-
-            //delete pkt;
-        }
-        else if(strcmp(msg->getName(),"haptic_data") == 0) {        // updating buffer size after receiving requests from ONUs
-            ethPacket *pkt = check_and_cast<ethPacket *>(msg);
-
-            pkt->setWapArrivalTime(pkt->getArrivalTime());
-            send(pkt,"Sfu_out");                                    // just forward to SFU
-            pkt->setWapDepartureTime(pkt->getSendingTime());
-
-            //delete pkt;
-        }
-    }
-    else {
-        EV << getFullName() << " Some unknown cMessage has arrived at = " << simTime() << endl;
+        default:
+            EV << getFullName() << " Some unknown cMessage has arrived at = " << simTime() << endl;
+            delete msg;
+            break;
     }
 }
-
-
-
-